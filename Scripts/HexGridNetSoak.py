@@ -0,0 +1,173 @@
+#!/usr/bin/env python3
+# Copyright 2024 Nic, Vlad, Alex
+"""
+Hex grid net soak: launches a dedicated server and N headless clients over loopback, runs a seeded tile change storm
+on the server (and optionally tile request storms on the clients), then combines the per process NetSoak CSVs that
+Asym.HexGrid.NetStatsRecord writes and prints a summary per role.
+
+Example, 8 clients with 2% loss and 80 ms lag, 500 edits/s for 120 s:
+    python Scripts/HexGridNetSoak.py --editor "C:/UE_5.5/Engine/Binaries/Win64/UnrealEditor.exe" --map /Game/Maps/Board \
+        --clients 8 --loss 2 --lag 80 --rate 500 --duration 120
+
+Needs a development build or the editor, the soak commands and the packet simulation are not in shipping builds.
+"""
+
+import argparse
+import csv
+import json
+import os
+import subprocess
+import sys
+import time
+from datetime import datetime
+
+PROJECT_DIR = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+PROJECT_FILE = os.path.join(PROJECT_DIR, "Asymptomagickal.uproject")
+OUTPUT_DIR = os.path.join(PROJECT_DIR, "Saved", "Profiling", "HexGrid")
+
+# Columns summarized per role, see FHexGridSoak::StartRecording for the full list
+SUMMARY_COLUMNS = ["OutBytesPerSecond", "InBytesPerSecond", "OutPacketsLost", "InPacketsLost", "AvgLagMs",
+                   "ApplyMs", "MaxRequestRPCsInFlight"]
+
+
+def parse_args():
+    parser = argparse.ArgumentParser(description="Launches a hex grid net soak and combines its CSVs")
+    parser.add_argument("--editor", default=os.environ.get("UE_EDITOR"),
+                        help="UnrealEditor executable (or UnrealEditor-Cmd), defaults to $UE_EDITOR")
+    parser.add_argument("--map", required=True, help="Map the server opens, e.g. /Game/Maps/Board")
+    parser.add_argument("--clients", type=int, default=4, help="Number of headless clients")
+    parser.add_argument("--loss", type=int, default=0, help="Packet loss in percent on every client (-PktLoss)")
+    parser.add_argument("--lag", type=int, default=0, help="Added lag in ms on every client (-PktLag)")
+    parser.add_argument("--rate", type=float, default=500.0, help="Server tile edits per second")
+    parser.add_argument("--duration", type=float, default=60.0, help="Seconds the storm runs")
+    parser.add_argument("--delay", type=float, default=20.0, help="Seconds before the storm starts, for the clients to join")
+    parser.add_argument("--seed", type=int, default=0, help="Seed of the storm, the same seed replays the same edits")
+    parser.add_argument("--request-rate", type=float, default=0.0,
+                        help="Tile requests per second every client sends through its UTileInteraction, 0 for none")
+    parser.add_argument("--per-tile", action="store_true", help="Clients send one RPC per requested tile like before batching")
+    parser.add_argument("--interval", type=float, default=1.0, help="Seconds between two recorded CSV rows")
+    parser.add_argument("--port", type=int, default=7777, help="Server port")
+    args = parser.parse_args()
+
+    if not args.editor or not os.path.isfile(args.editor):
+        parser.error("--editor has to point to the UnrealEditor executable")
+    if args.clients < 0 or args.duration <= 0 or args.rate <= 0:
+        parser.error("--clients, --duration and --rate have to be positive")
+    return args
+
+
+def launch(args, name, url, extra_args, exec_cmds):
+    command = [args.editor, PROJECT_FILE, url] + extra_args + [
+        "-nullrhi", "-nosound", "-nosteam", "-unattended", "-nosplash", "-log",
+        "-abslog=" + os.path.join(OUTPUT_DIR, "NetSoak-{}.log".format(name)),
+        "-ExecCmds=" + ", ".join(exec_cmds),
+    ]
+    print("Launching {}: {}".format(name, " ".join(command)))
+    return subprocess.Popen(command, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+
+
+def stop(processes):
+    for process in processes:
+        if process.poll() is None:
+            process.terminate()
+    for process in processes:
+        try:
+            process.wait(timeout=30)
+        except subprocess.TimeoutExpired:
+            process.kill()
+
+
+def read_rows(start_time):
+    """Rows of every NetSoak CSV written by this run, tagged with the file they came from"""
+    rows = []
+    for file_name in sorted(os.listdir(OUTPUT_DIR)):
+        path = os.path.join(OUTPUT_DIR, file_name)
+        if not (file_name.startswith("NetSoak-") and file_name.endswith(".csv")) or os.path.getmtime(path) < start_time:
+            continue
+        if file_name.startswith("NetSoak-Combined-"):
+            continue
+        with open(path, newline="") as csv_file:
+            for row in csv.DictReader(csv_file):
+                row["Process"] = file_name[len("NetSoak-"):-len(".csv")]
+                rows.append(row)
+    return rows
+
+
+def summarize(rows):
+    summary = {}
+    for role in sorted({row["Role"] for row in rows}):
+        role_rows = [row for row in rows if row["Role"] == role]
+        role_summary = {"Rows": len(role_rows), "Processes": len({row["Process"] for row in role_rows})}
+        for column in SUMMARY_COLUMNS:
+            values = [float(row[column]) for row in role_rows if row.get(column) not in (None, "")]
+            if values:
+                role_summary[column] = {"Mean": sum(values) / len(values), "Max": max(values)}
+        summary[role] = role_summary
+    return summary
+
+
+def main():
+    args = parse_args()
+    os.makedirs(OUTPUT_DIR, exist_ok=True)
+    start_time = time.time()
+
+    server_cmds = [
+        "Asym.HexGrid.NetStatsRecord {}".format(args.interval),
+        "Asym.HexGrid.Soak {} {} {} {}".format(args.rate, args.duration, args.delay, args.seed),
+    ]
+    client_cmds = ["Asym.HexGrid.NetStatsRecord {}".format(args.interval)]
+    # Read by the packet simulation when the client's net driver starts, before it connects
+    client_args = ["-game", "-windowed", "-PktLoss={}".format(args.loss), "-PktLag={}".format(args.lag)]
+
+    processes = [launch(args, "Server", args.map, ["-server", "-port={}".format(args.port)], server_cmds)]
+    try:
+        # The server has to listen before the clients connect
+        time.sleep(10)
+        for client_index in range(args.clients):
+            cmds = list(client_cmds)
+            if args.request_rate > 0:
+                # Every client requests its own tiles, the seed keeps runs repeatable
+                cmds.append("Asym.HexGrid.RequestSoak {} {} {} {} {}".format(
+                    args.request_rate, args.duration, max(args.delay - 10, 0), args.seed + client_index + 1, int(args.per_tile)))
+            processes.append(launch(args, "Client{}".format(client_index), "127.0.0.1:{}".format(args.port), client_args, cmds))
+
+        # The storm starts after the delay, counted from when the server loaded the map
+        end_time = start_time + 10 + args.delay + args.duration + 5 + 2 * args.interval
+        while time.time() < end_time:
+            if processes[0].poll() is not None:
+                print("The server exited early with code {}".format(processes[0].returncode), file=sys.stderr)
+                break
+            time.sleep(1)
+    finally:
+        stop(processes)
+
+    rows = read_rows(start_time)
+    if not rows:
+        print("No NetSoak CSVs were written to {}".format(OUTPUT_DIR), file=sys.stderr)
+        return 1
+
+    stamp = datetime.now().strftime("%Y.%m.%d-%H.%M.%S")
+    combined_path = os.path.join(OUTPUT_DIR, "NetSoak-Combined-{}.csv".format(stamp))
+    columns = ["Process"] + [column for column in rows[0].keys() if column != "Process"]
+    with open(combined_path, "w", newline="") as csv_file:
+        writer = csv.DictWriter(csv_file, fieldnames=columns, extrasaction="ignore")
+        writer.writeheader()
+        writer.writerows(rows)
+
+    summary = {
+        "Settings": {"Clients": args.clients, "LossPercent": args.loss, "LagMs": args.lag, "EditsPerSecond": args.rate,
+                     "Seconds": args.duration, "Seed": args.seed, "RequestsPerSecond": args.request_rate,
+                     "PerTileRPCs": args.per_tile},
+        "Roles": summarize(rows),
+    }
+    summary_path = os.path.join(OUTPUT_DIR, "NetSoak-Combined-{}.json".format(stamp))
+    with open(summary_path, "w") as json_file:
+        json.dump(summary, json_file, indent=2)
+
+    print(json.dumps(summary, indent=2))
+    print("Combined {} rows into {}, summary in {}".format(len(rows), combined_path, summary_path))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -43,8 +43,26 @@ public:
 	AAsymCharacter* GetAsymCharacterFromActorInfo() const;
 
 	FORCEINLINE EAsymAbilityActivationPolicy GetActivationPolicy() const {return ActivationPolicy;}
+	FORCEINLINE float GetInputBufferWindow() const {return InputBufferWindow;}
+
+	/** Called on the locally controlling machine when an activation failed, locally or on the server */
+	void OnAbilityFailedToActivate(const FGameplayTagContainer& FailedReason) const
+	{
+		NativeOnAbilityFailedToActivate(FailedReason);
+		ScriptOnAbilityFailedToActivate(FailedReason);
+	}
 
 protected:
+	virtual void NativeOnAbilityFailedToActivate(const FGameplayTagContainer& FailedReason) const {}
+
+	/** Feedback for a failed activation, e.g. a UI message for the failure tag */
+	UFUNCTION(BlueprintImplementableEvent, Category = "Ability", DisplayName = "OnAbilityFailedToActivate")
+	void ScriptOnAbilityFailedToActivate(const FGameplayTagContainer& FailedReason) const;
+
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability Activation")
 	EAsymAbilityActivationPolicy ActivationPolicy;
+
+	/** A press that could not activate the ability is retried for this many seconds, 0 drops it right away */
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Ability Activation", meta = (ClampMin = "0", Units = "s", EditCondition = "ActivationPolicy == EAsymAbilityActivationPolicy::AAP_OnInputTriggered"))
+	float InputBufferWindow = 0.f;
 };
@@ -5,6 +5,7 @@
 
 #include "Ability/AsymGameplayAbility.h"
 #include "Asymptomagickal/AsymLogChannels.h"
+#include "GameplayTagsManager.h"
 
 #include UE_INLINE_GENERATED_CPP_BY_NAME(AsymAbilitySystemComponent)
 
@@ -20,13 +21,20 @@ void UAsymAbilitySystemComponent::AbilityInputTagPressed(const FGameplayTag& Inp
 		return;
 	}
 
+	const FInputSpecHandles* SpecHandles = InputTagSpecHandles.Find(InputTag);
+	if (!SpecHandles)
+	{
+		return;
+	}
+
 	ABILITYLIST_SCOPE_LOCK(); // Prevent changes in the Ability Array while iterating over it
-	for (const FGameplayAbilitySpec& AbilitySpec : ActivatableAbilities.Items)
+	for (const FGameplayAbilitySpecHandle& SpecHandle : *SpecHandles)
 	{
-		if(AbilitySpec.Ability && AbilitySpec.GetDynamicSpecSourceTags().HasTagExact(InputTag))
+		const FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandleCached(SpecHandle);
+		if(AbilitySpec && AbilitySpec->Ability && AbilitySpec->GetDynamicSpecSourceTags().HasTagExact(InputTag))
 		{
-			InputPressedSpecHandles.AddUnique(AbilitySpec.Handle);
-			InputHeldSpecHandles.AddUnique(AbilitySpec.Handle);
+			InputPressedSpecHandles.Add(AbilitySpec->Handle);
+			InputHeldSpecHandles.Add(AbilitySpec->Handle);
 		}
 	}
 }
@@ -38,26 +46,39 @@ void UAsymAbilitySystemComponent::AbilityInputTagReleased(const FGameplayTag& In
 		return;
 	}
 	
+	const FInputSpecHandles* SpecHandles = InputTagSpecHandles.Find(InputTag);
+	if (!SpecHandles)
+	{
+		return;
+	}
+
 	ABILITYLIST_SCOPE_LOCK();
-	for (const FGameplayAbilitySpec& AbilitySpec : ActivatableAbilities.Items)
+	for (const FGameplayAbilitySpecHandle& SpecHandle : *SpecHandles)
 	{
-		if (AbilitySpec.Ability && (AbilitySpec.GetDynamicSpecSourceTags().HasTagExact(InputTag)))
+		const FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandleCached(SpecHandle);
+		if (AbilitySpec && AbilitySpec->Ability && (AbilitySpec->GetDynamicSpecSourceTags().HasTagExact(InputTag)))
 		{
-			InputReleasedSpecHandles.AddUnique(AbilitySpec.Handle);
-			InputHeldSpecHandles.Remove(AbilitySpec.Handle);
+			InputReleasedSpecHandles.Add(AbilitySpec->Handle);
+			InputHeldSpecHandles.Remove(AbilitySpec->Handle);
 		}
 	}
 }
 
 void UAsymAbilitySystemComponent::ProcessAbilityInput(float DeltaTime, bool bGamePaused)
 {
-	static TArray<FGameplayAbilitySpecHandle> AbilitiesToActivate;
 	AbilitiesToActivate.Reset();
 
+	// Only predicting clients send activation RPCs
+	bBatchingActivations = bBatchActivationRPCs && !IsOwnerActorAuthoritative();
+	PendingActivations.Reset();
+
+	const double Now = GetWorld()->GetRealTimeSeconds();
+	ProcessBufferedInput(Now);
+
 	// Held Abilities
 	for (const FGameplayAbilitySpecHandle& SpecHandle : InputHeldSpecHandles)
 	{
-		if (const FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandle(SpecHandle))
+		if (const FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandleCached(SpecHandle))
 		{
 			if (AbilitySpec->Ability && !AbilitySpec->IsActive())
 			{
@@ -65,7 +86,7 @@ void UAsymAbilitySystemComponent::ProcessAbilityInput(float DeltaTime, bool bGam
 
 				if(Ability->GetActivationPolicy() == EAsymAbilityActivationPolicy::AAP_WhileInputActive)
 				{
-					AbilitiesToActivate.AddUnique(AbilitySpec->Handle);
+					AbilitiesToActivate.Add(AbilitySpec->Handle);
 				}
 			}
 		}
@@ -74,7 +95,7 @@ void UAsymAbilitySystemComponent::ProcessAbilityInput(float DeltaTime, bool bGam
 	// Pressed Abilities
 	for (const FGameplayAbilitySpecHandle& SpecHandle : InputPressedSpecHandles)
 	{
-		if (FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandle(SpecHandle))
+		if (FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandleCached(SpecHandle))
 		{
 			if (AbilitySpec->Ability)
 			{
@@ -90,7 +111,7 @@ void UAsymAbilitySystemComponent::ProcessAbilityInput(float DeltaTime, bool bGam
 
 					if (Ability->GetActivationPolicy() == EAsymAbilityActivationPolicy::AAP_OnInputTriggered)
 					{
-						AbilitiesToActivate.AddUnique(AbilitySpec->Handle);
+						AbilitiesToActivate.Add(AbilitySpec->Handle);
 					}
 				}
 			}
@@ -100,12 +121,19 @@ void UAsymAbilitySystemComponent::ProcessAbilityInput(float DeltaTime, bool bGam
 	// Released Abilities
 	for (const FGameplayAbilitySpecHandle& AbilitySpecHandle : AbilitiesToActivate)
 	{
-		TryActivateAbility(AbilitySpecHandle);
+		if (!TryActivateAbility(AbilitySpecHandle) && InputPressedSpecHandles.Contains(AbilitySpecHandle))
+		{
+			BufferAbilityInput(AbilitySpecHandle, Now);
+		}
 	}
+
+	// Before the releases, ability tasks forward those to the server on their own
+	FlushPendingActivations();
+	bBatchingActivations = false;
 	
 	for (const FGameplayAbilitySpecHandle& SpecHandle : InputReleasedSpecHandles)
 	{
-		if (FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandle(SpecHandle))
+		if (FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandleCached(SpecHandle))
 		{
 			if (AbilitySpec->Ability)
 			{
@@ -123,11 +151,197 @@ void UAsymAbilitySystemComponent::ProcessAbilityInput(float DeltaTime, bool bGam
 	InputReleasedSpecHandles.Reset();
 }
 
+void UAsymAbilitySystemComponent::FlushPendingActivations()
+{
+	if (PendingActivations.Num() == 1)
+	{
+		ServerTryActivateAbility(PendingActivations[0].Handle, PendingActivations[0].bInputPressed, PendingActivations[0].PredictionKey);
+	}
+	else if (PendingActivations.Num() > 1)
+	{
+		ServerTryActivateAbilities(PendingActivations);
+	}
+	PendingActivations.Reset();
+}
+
+void UAsymAbilitySystemComponent::CallServerTryActivateAbility(FGameplayAbilitySpecHandle AbilityToActivate, bool InputPressed, FPredictionKey PredictionKey)
+{
+	// Abilities batching their own RPCs (FScopedServerAbilityRPCBatcher) need theirs to stay together
+	if (!bBatchingActivations || LocalServerAbilityRPCBatchData.ContainsByPredicate([AbilityToActivate](const FServerAbilityRPCBatch& Batch)
+		{
+			return Batch.AbilitySpecHandle == AbilityToActivate;
+		}))
+	{
+		Super::CallServerTryActivateAbility(AbilityToActivate, InputPressed, PredictionKey);
+		return;
+	}
+
+	if (PendingActivations.Num() == MaxActivationsPerRPC)
+	{
+		FlushPendingActivations();
+	}
+	PendingActivations.Add({AbilityToActivate, InputPressed, PredictionKey});
+}
+
+void UAsymAbilitySystemComponent::CallServerSetReplicatedTargetData(FGameplayAbilitySpecHandle AbilityHandle, FPredictionKey AbilityOriginalPredictionKey, const FGameplayAbilityTargetDataHandle& ReplicatedTargetDataHandle, FGameplayTag ApplicationTag, FPredictionKey CurrentPredictionKey)
+{
+	FlushPendingActivations();
+	Super::CallServerSetReplicatedTargetData(AbilityHandle, AbilityOriginalPredictionKey, ReplicatedTargetDataHandle, ApplicationTag, CurrentPredictionKey);
+}
+
+void UAsymAbilitySystemComponent::CallServerEndAbility(FGameplayAbilitySpecHandle AbilityToEnd, FGameplayAbilityActivationInfo ActivationInfo, FPredictionKey PredictionKey)
+{
+	FlushPendingActivations();
+	Super::CallServerEndAbility(AbilityToEnd, ActivationInfo, PredictionKey);
+}
+
+void UAsymAbilitySystemComponent::ReplicateEndOrCancelAbility(FGameplayAbilitySpecHandle Handle, FGameplayAbilityActivationInfo ActivationInfo, UGameplayAbility* Ability, bool bWasCanceled)
+{
+	// Cancels go out as ServerCancelAbility, which has no CallServer hook
+	FlushPendingActivations();
+	Super::ReplicateEndOrCancelAbility(Handle, ActivationInfo, Ability, bWasCanceled);
+}
+
+void UAsymAbilitySystemComponent::ServerTryActivateAbilities_Implementation(const TArray<FAsymAbilityActivation>& Activations)
+{
+	// Clients never send more, the rest of a bigger batch is not worth activating
+	const int32 NumActivations = FMath::Min(Activations.Num(), MaxActivationsPerRPC);
+	if (NumActivations < Activations.Num())
+	{
+		UE_LOG(LogAsymAbilitySystem, Warning, TEXT("Batched activations from %s: dropped %d activations over the limit of %d"),
+			*GetNameSafe(GetOwner()), Activations.Num() - NumActivations, MaxActivationsPerRPC);
+	}
+
+	for (int32 ActivationIndex = 0; ActivationIndex < NumActivations; ++ActivationIndex)
+	{
+		const FAsymAbilityActivation& Activation = Activations[ActivationIndex];
+		InternalServerTryActivateAbility(Activation.Handle, Activation.bInputPressed, Activation.PredictionKey, nullptr);
+	}
+}
+
+FGameplayAbilitySpec* UAsymAbilitySystemComponent::FindAbilitySpecFromHandleCached(const FGameplayAbilitySpecHandle Handle)
+{
+	if (const int32* Slot = SpecSlotCache.Find(Handle))
+	{
+		if (ActivatableAbilities.Items.IsValidIndex(*Slot) && ActivatableAbilities.Items[*Slot].Handle == Handle)
+		{
+			return &ActivatableAbilities.Items[*Slot];
+		}
+	}
+
+	FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandle(Handle);
+
+	// Pending specs given during an ability list lock are not in the items yet, they are cached on the next lookup
+	const int32 Slot = AbilitySpec ? UE_PTRDIFF_TO_INT32(AbilitySpec - ActivatableAbilities.Items.GetData()) : INDEX_NONE;
+	if (ActivatableAbilities.Items.IsValidIndex(Slot))
+	{
+		SpecSlotCache.Add(Handle, Slot);
+	}
+
+	return AbilitySpec;
+}
+
+void UAsymAbilitySystemComponent::OnGiveAbility(FGameplayAbilitySpec& AbilitySpec)
+{
+	Super::OnGiveAbility(AbilitySpec);
+
+	for (const FGameplayTag& InputTag : AbilitySpec.GetDynamicSpecSourceTags())
+	{
+		InputTagSpecHandles.FindOrAdd(InputTag).AddUnique(AbilitySpec.Handle);
+	}
+}
+
+void UAsymAbilitySystemComponent::OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec)
+{
+	for (const FGameplayTag& InputTag : AbilitySpec.GetDynamicSpecSourceTags())
+	{
+		if (FInputSpecHandles* SpecHandles = InputTagSpecHandles.Find(InputTag))
+		{
+			SpecHandles->Remove(AbilitySpec.Handle);
+			if (SpecHandles->IsEmpty())
+			{
+				InputTagSpecHandles.Remove(InputTag);
+			}
+		}
+	}
+	SpecSlotCache.Remove(AbilitySpec.Handle);
+	LastAbilityFailedNotifyTimes.Remove(AbilitySpec.Handle);
+
+	Super::OnRemoveAbility(AbilitySpec);
+}
+
 void UAsymAbilitySystemComponent::ClearAbilityInput()
 {
 	InputPressedSpecHandles.Reset();
 	InputReleasedSpecHandles.Reset();
 	InputHeldSpecHandles.Reset();
+	NumBufferedInputs = 0;
+}
+
+void UAsymAbilitySystemComponent::BufferAbilityInput(const FGameplayAbilitySpecHandle& Handle, const double PressTime)
+{
+	const FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandleCached(Handle);
+	const UAsymGameplayAbility* Ability = AbilitySpec ? Cast<UAsymGameplayAbility>(AbilitySpec->Ability) : nullptr;
+	if (!Ability || Ability->GetInputBufferWindow() <= 0.f)
+	{
+		return;
+	}
+
+	// Mashing only restarts the window of the press already buffered
+	for (int32 Offset = 0; Offset < NumBufferedInputs; ++Offset)
+	{
+		FBufferedInput& BufferedInput = BufferedInputs[(BufferedInputsHead + Offset) % InputBufferCapacity];
+		if (BufferedInput.Handle == Handle)
+		{
+			BufferedInput.PressTime = PressTime;
+			return;
+		}
+	}
+
+	if (NumBufferedInputs == InputBufferCapacity)
+	{
+		BufferedInputsHead = (BufferedInputsHead + 1) % InputBufferCapacity;
+		--NumBufferedInputs;
+	}
+
+	BufferedInputs[(BufferedInputsHead + NumBufferedInputs) % InputBufferCapacity] = {Handle, PressTime};
+	++NumBufferedInputs;
+}
+
+void UAsymAbilitySystemComponent::ProcessBufferedInput(const double Now)
+{
+	// Kept presses are compacted towards the head in order
+	int32 NumKept = 0;
+
+	for (int32 Offset = 0; Offset < NumBufferedInputs; ++Offset)
+	{
+		const FBufferedInput BufferedInput = BufferedInputs[(BufferedInputsHead + Offset) % InputBufferCapacity];
+
+		const FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandleCached(BufferedInput.Handle);
+		const UAsymGameplayAbility* Ability = AbilitySpec ? Cast<UAsymGameplayAbility>(AbilitySpec->Ability) : nullptr;
+		if (!Ability || AbilitySpec->IsActive() || Now - BufferedInput.PressTime > Ability->GetInputBufferWindow())
+		{
+			continue;
+		}
+
+		// Checked first so waiting presses neither report failures nor send activation RPCs every frame
+		if (Ability->CanActivateAbility(BufferedInput.Handle, AbilityActorInfo.Get()) && TryActivateAbility(BufferedInput.Handle))
+		{
+			continue;
+		}
+
+		// A failed activation expires the press in its slot, the copy above predates that
+		const FBufferedInput& CurrentInput = BufferedInputs[(BufferedInputsHead + Offset) % InputBufferCapacity];
+		if (Now - CurrentInput.PressTime > Ability->GetInputBufferWindow())
+		{
+			continue;
+		}
+
+		BufferedInputs[(BufferedInputsHead + NumKept) % InputBufferCapacity] = CurrentInput;
+		++NumKept;
+	}
+
+	NumBufferedInputs = NumKept;
 }
 
 void UAsymAbilitySystemComponent::AbilitySpecInputPressed(FGameplayAbilitySpec& Spec)
@@ -161,12 +375,51 @@ void UAsymAbilitySystemComponent::NotifyAbilityFailed(const FGameplayAbilitySpec
 	{
 		if (!Avatar->IsLocallyControlled() && Ability->IsSupportedForNetworking())
 		{
-			//Client notify ability failed rpc
+			// Unreliable and throttled, it is only feedback and must not grow with clients retrying
+			const double Now = GetWorld()->GetRealTimeSeconds();
+			double& LastNotifyTime = LastAbilityFailedNotifyTimes.FindOrAdd(Handle, -UE_BIG_NUMBER);
+			if (Now - LastNotifyTime < AbilityFailedNotifyInterval)
+			{
+				return;
+			}
+			LastNotifyTime = Now;
+
+			const UGameplayTagsManager& TagsManager = UGameplayTagsManager::Get();
+			TArray<uint16, TInlineAllocator<4>> FailureTagIndices;
+			for (const FGameplayTag& FailureTag : FailureReason)
+			{
+				const FGameplayTagNetIndex NetIndex = TagsManager.GetNetIndexFromTag(FailureTag);
+				if (NetIndex != INVALID_TAGNETINDEX)
+				{
+					FailureTagIndices.Add(NetIndex);
+				}
+			}
+
+			ClientNotifyAbilityFailed(Handle, TArray<uint16>(FailureTagIndices));
 			return;
 		}
 	}
 
-	HandleAbilityFailed(Ability, FailureReason);
+	HandleAbilityFailed(Handle, Ability, FailureReason);
+}
+
+void UAsymAbilitySystemComponent::ClientNotifyAbilityFailed_Implementation(const FGameplayAbilitySpecHandle Handle, const TArray<uint16>& FailureTagIndices)
+{
+	const FGameplayAbilitySpec* AbilitySpec = FindAbilitySpecFromHandleCached(Handle);
+	if (!AbilitySpec || !AbilitySpec->Ability)
+	{
+		return;
+	}
+
+	// Net indices match as long as client and server were built with the same tag tables
+	const UGameplayTagsManager& TagsManager = UGameplayTagsManager::Get();
+	FGameplayTagContainer FailureReason;
+	for (const uint16 NetIndex : FailureTagIndices)
+	{
+		FailureReason.AddTag(TagsManager.RequestGameplayTag(TagsManager.GetTagNameFromNetIndex(NetIndex), false));
+	}
+
+	HandleAbilityFailed(Handle, AbilitySpec->Ability, FailureReason);
 }
 
 void UAsymAbilitySystemComponent::NotifyAbilityEnded(FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, bool bWasCancelled)
@@ -174,9 +427,24 @@ void UAsymAbilitySystemComponent::NotifyAbilityEnded(FGameplayAbilitySpecHandle
 	Super::NotifyAbilityEnded(Handle, Ability, bWasCancelled);
 }
 
-void UAsymAbilitySystemComponent::HandleAbilityFailed(const UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason)
+void UAsymAbilitySystemComponent::HandleAbilityFailed(const FGameplayAbilitySpecHandle Handle, const UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason)
 {
 	UE_LOG(LogAsymAbilitySystem, Warning, TEXT("Ability %s failed to activate (tags: %s)"), *GetPathNameSafe(Ability), *FailureReason.ToString());
 
-	//TODO Add logic into the ability base class to handle fails and call here
+	if (const UAsymGameplayAbility* AsymAbility = Cast<const UAsymGameplayAbility>(Ability))
+	{
+		AsymAbility->OnAbilityFailedToActivate(FailureReason);
+	}
+
+	// The failure answers the press, retrying it would fail the same way
+	for (int32 Offset = 0; Offset < NumBufferedInputs; ++Offset)
+	{
+		FBufferedInput& BufferedInput = BufferedInputs[(BufferedInputsHead + Offset) % InputBufferCapacity];
+		if (BufferedInput.Handle == Handle)
+		{
+			BufferedInput.PressTime = -UE_BIG_NUMBER;
+		}
+	}
+
+	OnAbilityFailed.Broadcast(Ability, FailureReason);
 }
@@ -6,6 +6,65 @@
 #include "AbilitySystemComponent.h"
 #include "AsymAbilitySystemComponent.generated.h"
 
+/**
+ * Ordered set of spec handles for the per frame input bookkeeping. Up to InlineCapacity handles it lives in inline
+ * storage, so the input queues do not allocate. Linear lookups beat hashing at this size.
+ */
+struct FAsymSpecHandleQueue
+{
+	static constexpr int32 InlineCapacity = 16;
+
+	/** Appends the handle unless it is queued already */
+	void Add(const FGameplayAbilitySpecHandle& Handle)
+	{
+		if (!Handles.Contains(Handle))
+		{
+			Handles.Add(Handle);
+		}
+	}
+
+	/** Removes the handle and keeps the order of the others */
+	void Remove(const FGameplayAbilitySpecHandle& Handle)
+	{
+		const int32 Index = Handles.Find(Handle);
+		if (Index != INDEX_NONE)
+		{
+			Handles.RemoveAt(Index, 1, EAllowShrinking::No);
+		}
+	}
+
+	bool Contains(const FGameplayAbilitySpecHandle& Handle) const { return Handles.Contains(Handle); }
+	int32 Num() const { return Handles.Num(); }
+	bool IsEmpty() const { return Handles.IsEmpty(); }
+	void Reset() { Handles.Reset(); }
+
+	auto begin() const { return Handles.begin(); }
+	auto end() const { return Handles.end(); }
+
+private:
+	TArray<FGameplayAbilitySpecHandle, TInlineAllocator<InlineCapacity>> Handles;
+};
+
+/**
+ * One client activation request inside a batched activation RPC
+ */
+USTRUCT()
+struct FAsymAbilityActivation
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	FGameplayAbilitySpecHandle Handle;
+
+	UPROPERTY()
+	bool bInputPressed = false;
+
+	UPROPERTY()
+	FPredictionKey PredictionKey;
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FAsymAbilityFailedDelegate, const UGameplayAbility*, Ability, const FGameplayTagContainer&, FailureTags);
+
 /**
  * UAsymAbilitySystemComponent
  *
@@ -15,6 +74,7 @@ UCLASS()
 class ASYMPTOMAGICKAL_API UAsymAbilitySystemComponent : public UAbilitySystemComponent
 {
 	GENERATED_BODY()
+	friend class FAsymAbilitySystemTestAccess;
 public:
 	UAsymAbilitySystemComponent(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get());
 	
@@ -24,7 +84,44 @@ public:
 	void ProcessAbilityInput(float DeltaTime, bool bGamePaused);
 	void ClearAbilityInput();
 
+	/** FindAbilitySpecFromHandle through a handle to slot cache, O(1) unless the abilities array was reordered */
+	FGameplayAbilitySpec* FindAbilitySpecFromHandleCached(const FGameplayAbilitySpecHandle Handle);
+
+	/**
+	 * Sends the activations queued while ProcessAbilityInput batches them, one by one if there is only one. Server RPCs of
+	 * the game an ability sends while it activates have to call this first, or they overtake the ability's activation.
+	 */
+	void FlushPendingActivations();
+
+	/** Activations one batched activation RPC carries at most, the client sends bigger batches in several and the server drops whatever lies beyond */
+	static constexpr int32 MaxActivationsPerRPC = 32;
+
+	/** Local activation failures, including the ones the server reports for this client, for UI feedback */
+	UPROPERTY(BlueprintAssignable, Category = "Abilities")
+	FAsymAbilityFailedDelegate OnAbilityFailed;
+
 protected:
+
+	/** Remembers a press that could not activate its ability, for retries within the ability's InputBufferWindow */
+	void BufferAbilityInput(const FGameplayAbilitySpecHandle& Handle, const double PressTime);
+
+	/** Activates buffered presses that became possible, drops the ones past their window */
+	void ProcessBufferedInput(const double Now);
+
+	/** Queues the activation while ProcessAbilityInput batches them, see bBatchActivationRPCs */
+	virtual void CallServerTryActivateAbility(FGameplayAbilitySpecHandle AbilityToActivate, bool InputPressed, FPredictionKey PredictionKey) override;
+
+	/** All send the queued activations first, so the server never sees target data, an end or a cancel before the activation */
+	virtual void CallServerSetReplicatedTargetData(FGameplayAbilitySpecHandle AbilityHandle, FPredictionKey AbilityOriginalPredictionKey, const FGameplayAbilityTargetDataHandle& ReplicatedTargetDataHandle, FGameplayTag ApplicationTag, FPredictionKey CurrentPredictionKey) override;
+	virtual void CallServerEndAbility(FGameplayAbilitySpecHandle AbilityToEnd, FGameplayAbilityActivationInfo ActivationInfo, FPredictionKey PredictionKey) override;
+	virtual void ReplicateEndOrCancelAbility(FGameplayAbilitySpecHandle Handle, FGameplayAbilityActivationInfo ActivationInfo, UGameplayAbility* Ability, bool bWasCanceled) override;
+
+	/** Activations of one input frame, activated in order as if they arrived one by one */
+	UFUNCTION(Server, Reliable)
+	void ServerTryActivateAbilities(const TArray<FAsymAbilityActivation>& Activations);
+
+	virtual void OnGiveAbility(FGameplayAbilitySpec& AbilitySpec) override;
+	virtual void OnRemoveAbility(FGameplayAbilitySpec& AbilitySpec) override;
  
 	virtual void AbilitySpecInputPressed(FGameplayAbilitySpec& Spec) override;
 	virtual void AbilitySpecInputReleased(FGameplayAbilitySpec& Spec) override;
@@ -33,14 +130,58 @@ protected:
 	virtual void NotifyAbilityFailed(const FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason) override;
 	virtual void NotifyAbilityEnded(FGameplayAbilitySpecHandle Handle, UGameplayAbility* Ability, bool bWasCancelled) override;
 
-	void HandleAbilityFailed(const UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason);
+	void HandleAbilityFailed(const FGameplayAbilitySpecHandle Handle, const UGameplayAbility* Ability, const FGameplayTagContainer& FailureReason);
+
+	/** Server activation failure of a remote client's ability, the failure tags are sent as gameplay tag net indices */
+	UFUNCTION(Client, Unreliable)
+	void ClientNotifyAbilityFailed(const FGameplayAbilitySpecHandle Handle, const TArray<uint16>& FailureTagIndices);
 
 protected:
+
+	/** Sends all activations ProcessAbilityInput triggers in one frame to the server in one RPC */
+	UPROPERTY(EditAnywhere, Category = "Input")
+	bool bBatchActivationRPCs = true;
+
+	/** Seconds between two failure notifications the server sends a client for the same ability */
+	UPROPERTY(EditAnywhere, Category = "Abilities", meta = (ClampMin = "0", Units = "s"))
+	float AbilityFailedNotifyInterval = 0.25f;
 	
 	// Handles to abilities that had their input pressed this frame.
-	TArray<FGameplayAbilitySpecHandle> InputPressedSpecHandles;
+	FAsymSpecHandleQueue InputPressedSpecHandles;
 	// Handles to abilities that had their input released this frame.
-	TArray<FGameplayAbilitySpecHandle> InputReleasedSpecHandles;
+	FAsymSpecHandleQueue InputReleasedSpecHandles;
 	// Handles to abilities that have their input held.
-	TArray<FGameplayAbilitySpecHandle> InputHeldSpecHandles;
+	FAsymSpecHandleQueue InputHeldSpecHandles;
+	// Scratch for ProcessAbilityInput, abilities to activate this frame in input order.
+	FAsymSpecHandleQueue AbilitiesToActivate;
+
+	struct FBufferedInput
+	{
+		FGameplayAbilitySpecHandle Handle;
+		double PressTime = 0.0;
+	};
+
+	// Presses waiting for their ability to become activatable, oldest first. The oldest is dropped when full.
+	static constexpr int32 InputBufferCapacity = 8;
+	FBufferedInput BufferedInputs[InputBufferCapacity];
+	int32 BufferedInputsHead = 0;
+	int32 NumBufferedInputs = 0;
+
+	// Activations queued while ProcessAbilityInput runs, sent when it ends.
+	TArray<FAsymAbilityActivation> PendingActivations;
+	bool bBatchingActivations = false;
+
+	// Server only, when each ability last reported a failure to its client.
+	TMap<FGameplayAbilitySpecHandle, double> LastAbilityFailedNotifyTimes;
+
+private:
+	/**
+	 * Input tag -> abilities carrying it in their dynamic spec source tags, filled when abilities are given (on clients
+	 * when they replicate). Input tags added to a spec after it was given are not picked up.
+	 */
+	using FInputSpecHandles = TArray<FGameplayAbilitySpecHandle, TInlineAllocator<2>>;
+	TMap<FGameplayTag, FInputSpecHandles> InputTagSpecHandles;
+
+	/** Handle -> index in ActivatableAbilities.Items, validated on every hit since removals reorder the items */
+	TMap<FGameplayAbilitySpecHandle, int32> SpecSlotCache;
 };
@@ -0,0 +1,135 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "Asymptomagickal/AbilitySystem/AsymAbilitySystemComponent.h"
+#include "AsymTestGameplayAbilities.h"
+#include "Asymptomagickal/Tests/AsymTestUtilities.h"
+#include "GameplayTagsManager.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+/**
+ * Test access to the input bookkeeping, UAsymAbilitySystemComponent befriends it
+ */
+class FAsymAbilitySystemTestAccess
+{
+public:
+	static int32 GetNumAbilitiesToActivate(const UAsymAbilitySystemComponent& AbilitySystemComponent) { return AbilitySystemComponent.AbilitiesToActivate.Num(); }
+	static int32 GetNumBufferedInputs(const UAsymAbilitySystemComponent& AbilitySystemComponent) { return AbilitySystemComponent.NumBufferedInputs; }
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FAsymAbilityInputAllocationTest, "Asym.AbilitySystem.Input.Allocations",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+/**
+ * Runs input frames of a predicting client with 8 held and 8 pressed inputs through ProcessAbilityInput, each input
+ * bound to its own ability. The held inputs stay down and their abilities activate while the input is active, the
+ * pressed ones are pressed before and released after every frame and their abilities buffer presses that fail.
+ * Once the lookups are cached and the buffer is full no frame may allocate.
+ * The avatar is a simulated proxy, TryActivateAbility turns it away before the ability is activated or an activation
+ * RPC is queued. Every frame tries all 16 activations, buffers the 8 presses and retries the buffered ones, but the
+ * engine's activation, which allocates by design, is not part of the measurement.
+ */
+bool FAsymAbilityInputAllocationTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumHeldInputs = 8;
+	static constexpr int32 NumPressedInputs = 8;
+	static constexpr int32 NumWarmupFrames = 2;
+	static constexpr int32 NumFrames = 100;
+
+	// Any tags do, only their identity matters to the input lookup
+	FGameplayTagContainer AllTags;
+	UGameplayTagsManager::Get().RequestAllGameplayTags(AllTags, false);
+	TArray<FGameplayTag> InputTags;
+	AllTags.GetGameplayTagArray(InputTags);
+	if (InputTags.Num() < NumHeldInputs + NumPressedInputs)
+	{
+		AddWarning(FString::Printf(TEXT("Only %d gameplay tags are registered, %d are needed"), InputTags.Num(), NumHeldInputs + NumPressedInputs));
+		return true;
+	}
+	const TArrayView<const FGameplayTag> HeldTags = MakeArrayView(InputTags.GetData(), NumHeldInputs);
+	const TArrayView<const FGameplayTag> PressedTags = MakeArrayView(InputTags.GetData() + NumHeldInputs, NumPressedInputs);
+
+	AsymTests::FScopedTestWorld TestWorld;
+
+	AActor* Owner = TestWorld.GetWorld()->SpawnActor<AActor>();
+	AActor* Avatar = TestWorld.GetWorld()->SpawnActor<AActor>();
+	UAsymAbilitySystemComponent* AbilitySystemComponent = NewObject<UAsymAbilitySystemComponent>(Owner);
+	AbilitySystemComponent->RegisterComponent();
+	AbilitySystemComponent->InitAbilityActorInfo(Owner, Avatar);
+
+	for (int32 TagIndex = 0; TagIndex < NumHeldInputs + NumPressedInputs; ++TagIndex)
+	{
+		FGameplayAbilitySpec AbilitySpec(TagIndex < NumHeldInputs ? UAsymTestAbility_WhileInputActive::StaticClass() : UAsymTestAbility_Buffered::StaticClass());
+		AbilitySpec.GetDynamicSpecSourceTags().AddTag(InputTags[TagIndex]);
+		AbilitySystemComponent->GiveAbility(AbilitySpec);
+	}
+
+	// Abilities are given on the authority, the owner only turns into a client afterwards so activations are batched
+	AbilitySystemComponent->SetIsReplicated(true);
+	Owner->SetRole(ROLE_AutonomousProxy);
+	AbilitySystemComponent->CacheIsNetSimulated();
+	Avatar->SetRole(ROLE_SimulatedProxy);
+	TestFalse(TEXT("The owner is a client"), AbilitySystemComponent->IsOwnerActorAuthoritative());
+
+	for (const FGameplayTag& HeldTag : HeldTags)
+	{
+		AbilitySystemComponent->AbilityInputTagPressed(HeldTag);
+	}
+
+	const auto RunFrame = [AbilitySystemComponent, &PressedTags]()
+	{
+		for (const FGameplayTag& PressedTag : PressedTags)
+		{
+			AbilitySystemComponent->AbilityInputTagPressed(PressedTag);
+		}
+		AbilitySystemComponent->ProcessAbilityInput(1.f / 60.f, false);
+		for (const FGameplayTag& PressedTag : PressedTags)
+		{
+			AbilitySystemComponent->AbilityInputTagReleased(PressedTag);
+		}
+	};
+
+	// The first frames fill the handle to slot cache and the input buffer
+	for (int32 Frame = 0; Frame < NumWarmupFrames; ++Frame)
+	{
+		RunFrame();
+	}
+	TestEqual(TEXT("Abilities tried each frame"), FAsymAbilitySystemTestAccess::GetNumAbilitiesToActivate(*AbilitySystemComponent), NumHeldInputs + NumPressedInputs);
+	TestEqual(TEXT("Buffered presses"), FAsymAbilitySystemTestAccess::GetNumBufferedInputs(*AbilitySystemComponent), NumPressedInputs);
+
+	if (!AsymTests::FScopedAllocationCounter::IsSupported())
+	{
+		AddWarning(TEXT("Allocations cannot be counted on this platform"));
+	}
+
+	int64 NumAllocations = 0;
+	const double StartTime = FPlatformTime::Seconds();
+	{
+		AsymTests::FScopedAllocationCounter AllocationCounter;
+		for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+		{
+			RunFrame();
+		}
+		NumAllocations = AllocationCounter.GetNumAllocations();
+	}
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+	TestEqual(TEXT("Buffered presses after the frames"), FAsymAbilitySystemTestAccess::GetNumBufferedInputs(*AbilitySystemComponent), NumPressedInputs);
+
+	AddInfo(FString::Printf(TEXT("%d held and %d pressed inputs: %.2f us per frame, %lld allocations in %d frames"),
+		NumHeldInputs, NumPressedInputs, Seconds * 1e6 / NumFrames, NumAllocations, NumFrames));
+
+	if (AsymTests::FScopedAllocationCounter::IsSupported())
+	{
+		TestEqual(TEXT("Heap allocations of the input frames"), NumAllocations, static_cast<int64>(0));
+	}
+
+	Owner->Destroy();
+	Avatar->Destroy();
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,39 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Asymptomagickal/AbilitySystem/Ability/AsymGameplayAbility.h"
+#include "AsymTestGameplayAbilities.generated.h"
+
+/**
+ * Abilities with the input settings the ability system tests need, they do nothing when activated.
+ * UHT cannot leave them out of builds without automation tests, so they are only hidden from the editor.
+ */
+
+/** Activated for as long as its input is held */
+UCLASS(NotBlueprintable, HideDropdown)
+class UAsymTestAbility_WhileInputActive : public UAsymGameplayAbility
+{
+	GENERATED_BODY()
+public:
+	UAsymTestAbility_WhileInputActive(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get())
+		: Super(ObjectInitializer)
+	{
+		ActivationPolicy = EAsymAbilityActivationPolicy::AAP_WhileInputActive;
+	}
+};
+
+/** Activated on press, a press that cannot activate it is buffered */
+UCLASS(NotBlueprintable, HideDropdown)
+class UAsymTestAbility_Buffered : public UAsymGameplayAbility
+{
+	GENERATED_BODY()
+public:
+	UAsymTestAbility_Buffered(const FObjectInitializer& ObjectInitializer = FObjectInitializer::Get())
+		: Super(ObjectInitializer)
+	{
+		ActivationPolicy = EAsymAbilityActivationPolicy::AAP_OnInputTriggered;
+		InputBufferWindow = 1.f;
+	}
+};
@@ -2,5 +2,25 @@
 
 #include "Asymptomagickal.h"
 #include "Modules/ModuleManager.h"
+#include "Asymptomagickal/Tests/AsymTestUtilities.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Asymptomagickal, "Asymptomagickal" );
+class FAsymptomagickalModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+#if WITH_DEV_AUTOMATION_TESTS
+		// Once for the whole run, threads still using the allocator it was put in front of are fine
+		AsymTests::InstallAllocationCounter();
+#endif
+	}
+
+	virtual void ShutdownModule() override
+	{
+#if WITH_DEV_AUTOMATION_TESTS
+		AsymTests::UninstallAllocationCounter();
+#endif
+	}
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FAsymptomagickalModule, Asymptomagickal, "Asymptomagickal" );
@@ -4,6 +4,9 @@
 #include "TileInteraction.h"
 
 #include "Asymptomagickal/AsymLogChannels.h"
+#include "Asymptomagickal/HexagonalGrid/HexGridNetStats.h"
+#include "GameFramework/PlayerController.h"
+#include "TimerManager.h"
 
 
 UTileInteraction::UTileInteraction()
@@ -24,40 +27,211 @@ bool UTileInteraction::GetTileDataFromHit(const FHitResult& Hit, FTileData& OutT
 	{
 		if (ITileInterface* TileInterface = Cast<ITileInterface>(Hit.GetActor()))
 		{
-			OutTileData = TileInterface->GetTileDataFromItem(Hit.Item);
+			// Instance indices are per component, so the hit component decides which tile it is
+			const int32 TileIndex = TileInterface->GetTileIndexFromInstance(Hit.GetComponent(), Hit.Item);
+			if (TileIndex == INDEX_NONE)
+			{
+				return false;
+			}
+
+			OutTileData = TileInterface->GetTileDataFromItem(TileIndex);
 			return true;
 		}
 	}
 	return false;
 }
 
+bool UTileInteraction::GetTileDataFromRay(AActor* GridActor, const FVector& Start, const FVector& End, FTileData& OutTileData)
+{
+	if (ITileInterface* TileInterface = Cast<ITileInterface>(GridActor))
+	{
+		int32 TileIndex;
+		FVector HitLocation;
+		if (TileInterface->RaycastTile(Start, End, TileIndex, HitLocation))
+		{
+			OutTileData = TileInterface->GetTileDataFromItem(TileIndex);
+			return true;
+		}
+	}
+	return false;
+}
+
+bool UTileInteraction::GetTileDataUnderCursor(AActor* GridActor, const float TraceDistance, FTileData& OutTileData)
+{
+	const APlayerController* PlayerController = Cast<APlayerController>(GetOwner());
+	if (!PlayerController || !PlayerController->IsLocalController())
+	{
+		return false;
+	}
+
+	FVector WorldLocation;
+	FVector WorldDirection;
+	if (!PlayerController->DeprojectMousePositionToWorld(WorldLocation, WorldDirection))
+	{
+		return false;
+	}
+
+	return GetTileDataFromRay(GridActor, WorldLocation, WorldLocation + WorldDirection * TraceDistance, OutTileData);
+}
+
+FGameplayTagContainer UTileInteraction::GetTileTags(const FTileData& TileData)
+{
+	return TileData.GetGameplayTags();
+}
+
 
 void UTileInteraction::RequestTileTagChange(AActor* GridActor, const int32 TileIndex, const FGameplayTagContainer NewTags)
 {
+	RequestTilesTagChange(GridActor, {TileIndex}, NewTags);
+}
+
+void UTileInteraction::RequestTilesTagChange(AActor* GridActor, const TArray<int32>& TileIndices, const FGameplayTagContainer NewTags)
+{
+	if (!GridActor || TileIndices.IsEmpty())
+	{
+		return;
+	}
+
+	const FTileStateBits StateBits = AsymTileState::FromTags(NewTags);
+	if (FMath::CountBits(StateBits) != NewTags.Num())
+	{
+		UE_LOG(LogAsym, Warning, TEXT("RequestTilesTagChange dropped tags that are not registered as tile state: %s"), *NewTags.ToString());
+	}
+
 	if (GetOwnerRole() == ROLE_Authority)
 	{
-		UE_LOG(LogAsym, Log, TEXT("Server RequestTileTagChange Called"));
-		Internal_RequestTileTagChange(GridActor, TileIndex, NewTags);
+		if (const int32 NumInvalidTiles = Internal_RequestTileStateChange(GridActor, TileIndices, StateBits))
+		{
+			UE_LOG(LogAsym, Warning, TEXT("RequestTilesTagChange skipped %d tiles not on %s"), NumInvalidTiles, *GetNameSafe(GridActor));
+		}
+		return;
 	}
-	else
+
+	FPendingGridRequests* GridRequests = PendingRequests.FindByPredicate([GridActor](const FPendingGridRequests& Pending)
+	{
+		return Pending.GridActor == GridActor;
+	});
+	if (!GridRequests)
 	{
-		UE_LOG(LogAsym, Log, TEXT("Client RequestTileTagChange Called"));
-		Server_RequestTileTagChange(GridActor, TileIndex, NewTags);
+		GridRequests = &PendingRequests.AddDefaulted_GetRef();
+		GridRequests->GridActor = GridActor;
+	}
+
+	for (const int32 TileIndex : TileIndices)
+	{
+		GridRequests->TileStates.Add(TileIndex, StateBits);
+	}
+
+	if (!bFlushScheduled)
+	{
+		bFlushScheduled = true;
+		GetWorld()->GetTimerManager().SetTimerForNextTick(this, &UTileInteraction::FlushTileRequests);
 	}
 }
 
-void UTileInteraction::Server_RequestTileTagChange_Implementation(AActor* GridActor, const int32 TileIndex, const FGameplayTagContainer& NewTags)
+void UTileInteraction::FlushTileRequests()
 {
-	UE_LOG(LogAsym, Log, TEXT("RPC Server_RequestTileTagChange Called"));
-	Internal_RequestTileTagChange(GridActor, TileIndex, NewTags);
+	bFlushScheduled = false;
+
+	for (FPendingGridRequests& GridRequests : PendingRequests)
+	{
+		if (!GridRequests.GridActor.IsValid() || GridRequests.TileStates.IsEmpty())
+		{
+			continue;
+		}
+
+		// Only a handful of distinct states exist, so a linear search per tile is cheaper than another map
+		int32 NumRequestTiles = 0;
+		for (const TPair<int32, FTileStateBits>& TileState : GridRequests.TileStates)
+		{
+			if (NumRequestTiles == MaxTilesPerRequest)
+			{
+				SendRequestScratch(GridRequests.GridActor.Get());
+				NumRequestTiles = 0;
+			}
+
+			FTileStateRequest* Request = RequestScratch.FindByPredicate([&TileState](const FTileStateRequest& Existing)
+			{
+				return Existing.StateBits == TileState.Value;
+			});
+			if (!Request)
+			{
+				Request = &RequestScratch.AddDefaulted_GetRef();
+				Request->StateBits = TileState.Value;
+				if (!TileIndicesPool.IsEmpty())
+				{
+					Request->TileIndices = TileIndicesPool.Pop(EAllowShrinking::No);
+				}
+			}
+			Request->TileIndices.Add(TileState.Key);
+			++NumRequestTiles;
+		}
+
+		SendRequestScratch(GridRequests.GridActor.Get());
+	}
+
+	PendingRequests.Reset();
 }
 
-void UTileInteraction::Internal_RequestTileTagChange(AActor* GridActor, const int32 TileIndex, const FGameplayTagContainer& NewTags)
+void UTileInteraction::SendRequestScratch(AActor* GridActor)
 {
-	UE_LOG(LogAsym, Log, TEXT("Internal_RequestTileTagChange Called"));
+	int32 NumTiles = 0;
+	for (const FTileStateRequest& Request : RequestScratch)
+	{
+		NumTiles += Request.TileIndices.Num();
+	}
+
+	UE_LOG(LogAsym, Verbose, TEXT("Sending %d tile requests in %d state groups"), NumTiles, RequestScratch.Num());
+	Server_RequestTileStateChanges(GridActor, RequestScratch);
+
+	FHexGridNetStats& NetStats = FHexGridNetStats::Get();
+	++NetStats.NumRequestRPCs;
+	NetStats.NumRequestedTiles += NumTiles;
 
+	for (FTileStateRequest& Request : RequestScratch)
+	{
+		Request.TileIndices.Reset();
+		TileIndicesPool.Add(MoveTemp(Request.TileIndices));
+	}
+	RequestScratch.Reset();
+}
+
+void UTileInteraction::Server_RequestTileStateChanges_Implementation(AActor* GridActor, const TArray<FTileStateRequest>& Requests)
+{
+	UE_LOG(LogAsym, Verbose, TEXT("RPC Server_RequestTileStateChanges Called with %d state groups"), Requests.Num());
+
+	// Honest clients send one group per state and never exceed the tile limit, anything beyond is dropped instead of applied
+	static constexpr int32 MaxStateGroups = AsymTileState::AllBits + 1;
+	int32 NumTileBudget = MaxTilesPerRequest;
+	int32 NumDroppedTiles = 0;
+	int32 NumInvalidTiles = 0;
+
+	for (int32 GroupIndex = 0; GroupIndex < Requests.Num(); ++GroupIndex)
+	{
+		const FTileStateRequest& Request = Requests[GroupIndex];
+		const int32 NumRequestTiles = GroupIndex < MaxStateGroups ? FMath::Min(Request.TileIndices.Num(), NumTileBudget) : 0;
+		NumDroppedTiles += Request.TileIndices.Num() - NumRequestTiles;
+		NumTileBudget -= NumRequestTiles;
+
+		if (NumRequestTiles > 0)
+		{
+			NumInvalidTiles += Internal_RequestTileStateChange(GridActor, MakeArrayView(Request.TileIndices.GetData(), NumRequestTiles), Request.StateBits);
+		}
+	}
+
+	// One line per RPC, a client sending garbage must not be able to flood the log
+	if (NumDroppedTiles > 0 || NumInvalidTiles > 0)
+	{
+		UE_LOG(LogAsym, Warning, TEXT("Tile request from %s: dropped %d tiles over the limit of %d, skipped %d tiles not on %s"),
+			*GetNameSafe(GetOwner()), NumDroppedTiles, MaxTilesPerRequest, NumInvalidTiles, *GetNameSafe(GridActor));
+	}
+}
+
+int32 UTileInteraction::Internal_RequestTileStateChange(AActor* GridActor, const TConstArrayView<int32> TileIndices, const FTileStateBits StateBits)
+{
 	if (ITileInterface* TileInterface = Cast<ITileInterface>(GridActor))
 	{
-		TileInterface->SetTagsOnTile(TileIndex, NewTags);
+		return TileInterface->SetStateOnTiles(TileIndices, StateBits, GetOwner());
 	}
+	return TileIndices.Num();
 }
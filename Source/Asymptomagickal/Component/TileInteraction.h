@@ -8,6 +8,21 @@
 #include "Components/ActorComponent.h"
 #include "TileInteraction.generated.h"
 
+/**
+ * Tiles that should all get the same state, the unit of the batched tile request RPC
+ */
+USTRUCT()
+struct FTileStateRequest
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	uint8 StateBits = AsymTileState::None;
+
+	UPROPERTY()
+	TArray<int32> TileIndices;
+};
+
 /*
 * The Interaction Component that allows Clients to send change requests to the server autoritative version of the grid
 */
@@ -23,12 +38,58 @@ public:
 	UFUNCTION(BlueprintCallable, Category="Tile Interaction")
 	bool GetTileDataFromHit(const FHitResult& Hit, FTileData& OutTileData);
 
+	/** Picks the tile along the world space segment analytically, works without collision on the grid */
+	UFUNCTION(BlueprintCallable, Category="Tile Interaction")
+	bool GetTileDataFromRay(AActor* GridActor, const FVector& Start, const FVector& End, FTileData& OutTileData);
+
+	/** Picks the tile under the mouse cursor of the owning player controller, suitable for per frame hover */
+	UFUNCTION(BlueprintCallable, Category="Tile Interaction")
+	bool GetTileDataUnderCursor(AActor* GridActor, const float TraceDistance, FTileData& OutTileData);
+
+	/** Expands the compact tile state back into gameplay tags */
+	UFUNCTION(BlueprintPure, Category="Tile Interaction")
+	static FGameplayTagContainer GetTileTags(const FTileData& TileData);
+
 	UFUNCTION(BlueprintCallable, Category="Tile Interaction")
 	void RequestTileTagChange(AActor* GridActor, const int32 TileIndex, const FGameplayTagContainer NewTags);
+
+	/**
+	 * Sets the tags on all tiles. On clients requests are queued and sent as one RPC per grid on the next tick,
+	 * a later request for the same tile within that frame replaces the earlier one.
+	 */
+	UFUNCTION(BlueprintCallable, Category="Tile Interaction")
+	void RequestTilesTagChange(AActor* GridActor, const TArray<int32>& TileIndices, const FGameplayTagContainer NewTags);
+
+	/** Sends all queued requests now instead of on the next tick */
+	void FlushTileRequests();
+
+	/** Tiles one request RPC carries at most, the client splits bigger batches and the server drops whatever lies beyond */
+	static constexpr int32 MaxTilesPerRequest = 2048;
 	
 private:
 	UFUNCTION(Server, Reliable)
-	void Server_RequestTileTagChange(AActor* GridActor, const int32 TileIndex, const FGameplayTagContainer& NewTags);
+	void Server_RequestTileStateChanges(AActor* GridActor, const TArray<FTileStateRequest>& Requests);
+
+	/** Returns how many of the tiles are not on the grid */
+	int32 Internal_RequestTileStateChange(AActor* GridActor, const TConstArrayView<int32> TileIndices, const FTileStateBits StateBits);
+
+	struct FPendingGridRequests
+	{
+		TWeakObjectPtr<AActor> GridActor;
+		/** TileIndex -> requested state, coalesces repeated edits of a tile */
+		TMap<int32, FTileStateBits> TileStates;
+	};
+
+	TArray<FPendingGridRequests> PendingRequests;
+
+	/** Sends the grouped requests as one RPC and returns their tile arrays to the pool */
+	void SendRequestScratch(AActor* GridActor);
+
+	// Reused between flushes to group the queued tiles by state
+	TArray<FTileStateRequest> RequestScratch;
+
+	// Tile arrays of sent groups, handed to the next groups so they keep their allocations
+	TArray<TArray<int32>> TileIndicesPool;
 
-	void Internal_RequestTileTagChange(AActor* GridActor, const int32 TileIndex, const FGameplayTagContainer& NewTags);
+	bool bFlushScheduled = false;
 };
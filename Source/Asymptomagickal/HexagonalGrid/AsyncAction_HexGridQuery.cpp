@@ -0,0 +1,101 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "AsyncAction_HexGridQuery.h"
+
+#include "Async/Async.h"
+
+UAsyncAction_HexGridQuery* UAsyncAction_HexGridQuery::FindPathAsync(AHexGrid* HexGrid, const int32 StartTileIndex, const int32 GoalTileIndex,
+	const FHexPathQuery& Query)
+{
+	UAsyncAction_HexGridQuery* Action = CreateAction(HexGrid, Query);
+	Action->QueryType = EQueryType::Path;
+	Action->TileIndex = StartTileIndex;
+	Action->GoalTileIndex = GoalTileIndex;
+	return Action;
+}
+
+UAsyncAction_HexGridQuery* UAsyncAction_HexGridQuery::FindReachableTilesAsync(AHexGrid* HexGrid, const int32 StartTileIndex, const float MaxCost,
+	const FHexPathQuery& Query)
+{
+	UAsyncAction_HexGridQuery* Action = CreateAction(HexGrid, Query);
+	Action->QueryType = EQueryType::Reachable;
+	Action->TileIndex = StartTileIndex;
+	Action->MaxCost = MaxCost;
+	return Action;
+}
+
+UAsyncAction_HexGridQuery* UAsyncAction_HexGridQuery::FindTilesInRangeAsync(AHexGrid* HexGrid, const int32 CenterTileIndex, const int32 Range,
+	const FHexPathQuery& Query)
+{
+	UAsyncAction_HexGridQuery* Action = CreateAction(HexGrid, Query);
+	Action->QueryType = EQueryType::Range;
+	Action->TileIndex = CenterTileIndex;
+	Action->Range = Range;
+	return Action;
+}
+
+UAsyncAction_HexGridQuery* UAsyncAction_HexGridQuery::CreateAction(AHexGrid* HexGrid, const FHexPathQuery& Query)
+{
+	UAsyncAction_HexGridQuery* Action = NewObject<UAsyncAction_HexGridQuery>();
+
+	Action->RegisterWithGameInstance(HexGrid);
+
+	if (HexGrid && Action->IsRegistered())
+	{
+		Action->HexGrid = HexGrid;
+		Action->Query = Query;
+	}
+	else
+	{
+		Action->SetReadyToDestroy();
+	}
+
+	return Action;
+}
+
+void UAsyncAction_HexGridQuery::Activate()
+{
+	const AHexGrid* Grid = HexGrid.Get();
+	if (!Grid)
+	{
+		HandleResult(FHexGridQueryResult());
+		return;
+	}
+
+	TFuture<FHexGridQueryResult> Future;
+	switch (QueryType)
+	{
+	case EQueryType::Path:
+		Future = Grid->FindPathAsync(TileIndex, GoalTileIndex, Query);
+		break;
+	case EQueryType::Reachable:
+		Future = Grid->FindReachableTilesAsync(TileIndex, MaxCost, Query);
+		break;
+	case EQueryType::Range:
+		Future = Grid->FindTilesInRangeAsync(TileIndex, Range, Query);
+		break;
+	}
+
+	// The future completes on the worker, the result is handed back to the game thread
+	Future.Next([WeakThis = TWeakObjectPtr<UAsyncAction_HexGridQuery>(this)](FHexGridQueryResult Result)
+	{
+		AsyncTask(ENamedThreads::GameThread, [WeakThis, Result = MoveTemp(Result)]()
+		{
+			if (UAsyncAction_HexGridQuery* Action = WeakThis.Get())
+			{
+				Action->HandleResult(Result);
+			}
+		});
+	});
+}
+
+void UAsyncAction_HexGridQuery::HandleResult(const FHexGridQueryResult& Result)
+{
+	if (ShouldBroadcastDelegates())
+	{
+		OnCompleted.Broadcast(Result);
+	}
+
+	SetReadyToDestroy();
+}
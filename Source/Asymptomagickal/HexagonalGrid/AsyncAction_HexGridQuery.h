@@ -0,0 +1,55 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexGrid.h"
+#include "Engine/CancellableAsyncAction.h"
+#include "AsyncAction_HexGridQuery.generated.h"
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FHexGridQueryCompleted, const FHexGridQueryResult&, Result);
+
+/**
+ * Latent Blueprint nodes for the async grid queries. The query runs on a worker thread, OnCompleted fires on the game thread.
+ */
+UCLASS()
+class ASYMPTOMAGICKAL_API UAsyncAction_HexGridQuery : public UCancellableAsyncAction
+{
+	GENERATED_BODY()
+public:
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Async", meta=(BlueprintInternalUseOnly="true"))
+	static UAsyncAction_HexGridQuery* FindPathAsync(AHexGrid* HexGrid, const int32 StartTileIndex, const int32 GoalTileIndex, const FHexPathQuery& Query);
+
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Async", meta=(BlueprintInternalUseOnly="true"))
+	static UAsyncAction_HexGridQuery* FindReachableTilesAsync(AHexGrid* HexGrid, const int32 StartTileIndex, const float MaxCost, const FHexPathQuery& Query);
+
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Async", meta=(BlueprintInternalUseOnly="true"))
+	static UAsyncAction_HexGridQuery* FindTilesInRangeAsync(AHexGrid* HexGrid, const int32 CenterTileIndex, const int32 Range, const FHexPathQuery& Query);
+
+	UPROPERTY(BlueprintAssignable)
+	FHexGridQueryCompleted OnCompleted;
+
+protected:
+	virtual void Activate() override;
+
+private:
+	static UAsyncAction_HexGridQuery* CreateAction(AHexGrid* HexGrid, const FHexPathQuery& Query);
+
+	void HandleResult(const FHexGridQueryResult& Result);
+
+	enum class EQueryType : uint8
+	{
+		Path,
+		Reachable,
+		Range
+	};
+
+	TWeakObjectPtr<AHexGrid> HexGrid;
+	EQueryType QueryType = EQueryType::Path;
+	FHexPathQuery Query;
+
+	int32 TileIndex = INDEX_NONE;
+	int32 GoalTileIndex = INDEX_NONE;
+	float MaxCost = 0.f;
+	int32 Range = 0;
+};
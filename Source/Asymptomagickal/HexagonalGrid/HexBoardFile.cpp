@@ -0,0 +1,123 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexBoardFile.h"
+
+#include "HexTileStore.h"
+#include "Asymptomagickal/AsymLogChannels.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Misc/Paths.h"
+
+FString FHexBoardFile::ResolvePath(const FString& FilePath)
+{
+	return FPaths::IsRelative(FilePath) ? FPaths::Combine(FPaths::ProjectDir(), FilePath) : FilePath;
+}
+
+bool FHexBoardFile::Save(const FString& FilePath, const FHexGridLayout& Layout, const FHexTileStore& Tiles)
+{
+	if (Tiles.Num() != Layout.Num())
+	{
+		return false;
+	}
+
+	TArray<float> Heights;
+	TArray<FTileStateBits> States;
+	Heights.SetNumUninitialized(Tiles.Num());
+	States.SetNumUninitialized(Tiles.Num());
+	for (int32 TileIndex = 0; TileIndex < Tiles.Num(); ++TileIndex)
+	{
+		Heights[TileIndex] = Tiles.GetHeight(TileIndex);
+		States[TileIndex] = Tiles.GetState(TileIndex);
+	}
+
+	FHeader Header = {};
+	Header.Magic = Magic;
+	Header.Version = FormatVersion;
+	Header.Rows = Layout.Rows;
+	Header.Columns = Layout.Columns;
+	Header.Radius = Layout.Radius;
+	Header.Checksum = FCrc::MemCrc32(States.GetData(), States.Num() * sizeof(FTileStateBits), FCrc::MemCrc32(Heights.GetData(), Heights.Num() * sizeof(float)));
+
+	const TUniquePtr<FArchive> Writer(IFileManager::Get().CreateFileWriter(*ResolvePath(FilePath)));
+	if (!Writer)
+	{
+		UE_LOG(LogAsym, Error, TEXT("Could not write board snapshot %s"), *FilePath);
+		return false;
+	}
+
+	Writer->Serialize(&Header, sizeof(Header));
+	Writer->Serialize(Heights.GetData(), Heights.Num() * sizeof(float));
+	Writer->Serialize(States.GetData(), States.Num() * sizeof(FTileStateBits));
+
+	return Writer->Close();
+}
+
+bool FHexBoardFile::Load(const FString& FilePath, FHexGridLayout& OutLayout, FHexTileStore& OutTiles, uint32& OutChecksum)
+{
+	const FString Path = ResolvePath(FilePath);
+
+	const TUniquePtr<IMappedFileHandle> MappedFile(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*Path));
+	if (!MappedFile || MappedFile->GetFileSize() < static_cast<int64>(sizeof(FHeader)))
+	{
+		UE_LOG(LogAsym, Error, TEXT("Could not map board snapshot %s"), *Path);
+		return false;
+	}
+
+	const TUniquePtr<IMappedFileRegion> Region(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	if (!Region)
+	{
+		UE_LOG(LogAsym, Error, TEXT("Could not map board snapshot %s"), *Path);
+		return false;
+	}
+
+	const uint8* Data = Region->GetMappedPtr();
+
+	FHeader Header;
+	FMemory::Memcpy(&Header, Data, sizeof(Header));
+
+	const int64 NumTiles = static_cast<int64>(Header.Rows) * Header.Columns;
+	if (Header.Magic != Magic || Header.Version != FormatVersion || Header.Rows <= 0 || Header.Columns <= 0
+		|| Region->GetMappedSize() != static_cast<int64>(sizeof(FHeader)) + NumTiles * (sizeof(float) + sizeof(FTileStateBits)))
+	{
+		UE_LOG(LogAsym, Error, TEXT("Board snapshot %s is not a valid version %u snapshot"), *Path, FormatVersion);
+		return false;
+	}
+
+	const float* Heights = reinterpret_cast<const float*>(Data + sizeof(FHeader));
+	const FTileStateBits* States = reinterpret_cast<const FTileStateBits*>(Heights + NumTiles);
+
+	const uint32 Checksum = FCrc::MemCrc32(States, NumTiles * sizeof(FTileStateBits), FCrc::MemCrc32(Heights, NumTiles * sizeof(float)));
+	if (Checksum != Header.Checksum)
+	{
+		UE_LOG(LogAsym, Error, TEXT("Board snapshot %s is corrupted"), *Path);
+		return false;
+	}
+
+	// The checksum only covers the payload, a hand edited header can still lay out an impossible board
+	if (!FMath::IsFinite(Header.Radius) || Header.Radius <= 0.f
+		|| 2.0 * Header.Radius * FMath::Max(Header.Rows, Header.Columns) > UE_LARGE_WORLD_MAX)
+	{
+		UE_LOG(LogAsym, Error, TEXT("Board snapshot %s has an invalid tile radius %f for %dx%d tiles"), *Path, Header.Radius, Header.Rows, Header.Columns);
+		return false;
+	}
+
+	// Replication rejects tiles with unknown state bits, a recomputed checksum does not make them valid
+	for (int64 TileIndex = 0; TileIndex < NumTiles; ++TileIndex)
+	{
+		if (States[TileIndex] & ~AsymTileState::AllBits)
+		{
+			UE_LOG(LogAsym, Error, TEXT("Board snapshot %s has unknown state bits 0x%x on tile %lld"), *Path, States[TileIndex], TileIndex);
+			return false;
+		}
+	}
+
+	OutLayout.Rows = Header.Rows;
+	OutLayout.Columns = Header.Columns;
+	OutLayout.Radius = Header.Radius;
+	OutTiles.Init(MakeArrayView(Heights, NumTiles), MakeArrayView(States, NumTiles));
+	OutChecksum = Checksum;
+
+	return true;
+}
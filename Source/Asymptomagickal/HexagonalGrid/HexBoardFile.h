@@ -0,0 +1,46 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexCoord.h"
+
+struct FHexTileStore;
+
+/**
+ * Binary board snapshot: a fixed header followed by the raw tile heights (float) and states (FTileStateBits) in tile index order.
+ * The payload is laid out exactly like the tile store reads it, so loading maps the file and copies it straight into the store.
+ * Little endian only, like every platform the project ships on.
+ */
+struct ASYMPTOMAGICKAL_API FHexBoardFile
+{
+	/** Bump when the layout of the header or payload changes, older files are rejected */
+	static constexpr uint32 FormatVersion = 1;
+
+	/** Relative paths are relative to the project directory */
+	static FString ResolvePath(const FString& FilePath);
+
+	static bool Save(const FString& FilePath, const FHexGridLayout& Layout, const FHexTileStore& Tiles);
+
+	/**
+	 * Maps the file and fills the layout dimensions and the store, OutChecksum identifies the payload.
+	 * Files with a bad checksum, tile radius or state bits are rejected.
+	 */
+	static bool Load(const FString& FilePath, FHexGridLayout& OutLayout, FHexTileStore& OutTiles, uint32& OutChecksum);
+
+private:
+	struct FHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		int32 Rows;
+		int32 Columns;
+		float Radius;
+		/** CRC of the payload */
+		uint32 Checksum;
+		uint32 Reserved[2];
+	};
+	static_assert(sizeof(FHeader) == 32, "The payload has to start 4 byte aligned right after the header");
+
+	static constexpr uint32 Magic = 0x47584548; // "HEXG"
+};
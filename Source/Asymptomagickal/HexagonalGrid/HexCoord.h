@@ -0,0 +1,378 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexCoord.generated.h"
+
+/**
+ * Axial hex coordinate (Q, R) with the implicit cube component S = -Q - R.
+ *
+ * The grid is flat-topped with odd columns pushed half a tile along +X, so Q follows the Column (world Y) and R runs along
+ * the Row (world X). See https://www.redblobgames.com/grids/hexagons/ for the math.
+ */
+USTRUCT(BlueprintType)
+struct ASYMPTOMAGICKAL_API FHexCoord
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Coord")
+	int32 Q = 0;
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Hex Coord")
+	int32 R = 0;
+
+	constexpr FHexCoord() = default;
+	constexpr FHexCoord(const int32 InQ, const int32 InR) : Q(InQ), R(InR) {}
+
+	constexpr int32 S() const { return -Q - R; }
+
+	constexpr FHexCoord operator+(const FHexCoord& Other) const { return FHexCoord(Q + Other.Q, R + Other.R); }
+	constexpr FHexCoord operator-(const FHexCoord& Other) const { return FHexCoord(Q - Other.Q, R - Other.R); }
+	constexpr FHexCoord operator*(const int32 Scale) const { return FHexCoord(Q * Scale, R * Scale); }
+	constexpr bool operator==(const FHexCoord& Other) const { return Q == Other.Q && R == Other.R; }
+	constexpr bool operator!=(const FHexCoord& Other) const { return !(*this == Other); }
+
+	/** Unit step towards one of the six neighbors, Direction wraps around */
+	static constexpr FHexCoord Direction(const int32 Direction)
+	{
+		constexpr int32 Deltas[6][2] = { {1, 0}, {1, -1}, {0, -1}, {-1, 0}, {-1, 1}, {0, 1} };
+		const int32 Wrapped = ((Direction % 6) + 6) % 6;
+		return FHexCoord(Deltas[Wrapped][0], Deltas[Wrapped][1]);
+	}
+
+	constexpr FHexCoord Neighbor(const int32 InDirection) const { return *this + Direction(InDirection); }
+
+	constexpr int32 Length() const
+	{
+		const int32 AbsQ = Q < 0 ? -Q : Q;
+		const int32 AbsR = R < 0 ? -R : R;
+		const int32 AbsS = S() < 0 ? -S() : S();
+		return (AbsQ + AbsR + AbsS) / 2;
+	}
+
+	static constexpr int32 Distance(const FHexCoord& A, const FHexCoord& B) { return (A - B).Length(); }
+
+	/** Conversion from and to the (Row, Column) layout the instances are created in */
+	static constexpr FHexCoord FromOffset(const int32 Row, const int32 Column)
+	{
+		return FHexCoord(Column, Row - (Column - (Column & 1)) / 2);
+	}
+
+	constexpr int32 GetRow() const { return R + (Q - (Q & 1)) / 2; }
+	constexpr int32 GetColumn() const { return Q; }
+
+	/** Rounds a fractional axial coordinate to the hex containing it */
+	static FHexCoord Round(const double FracQ, const double FracR)
+	{
+		const double FracS = -FracQ - FracR;
+
+		double RoundedQ = FMath::RoundHalfFromZero(FracQ);
+		double RoundedR = FMath::RoundHalfFromZero(FracR);
+		const double RoundedS = FMath::RoundHalfFromZero(FracS);
+
+		const double DiffQ = FMath::Abs(RoundedQ - FracQ);
+		const double DiffR = FMath::Abs(RoundedR - FracR);
+		const double DiffS = FMath::Abs(RoundedS - FracS);
+
+		if (DiffQ > DiffR && DiffQ > DiffS)
+		{
+			RoundedQ = -RoundedR - RoundedS;
+		}
+		else if (DiffR > DiffS)
+		{
+			RoundedR = -RoundedQ - RoundedS;
+		}
+
+		return FHexCoord(static_cast<int32>(RoundedQ), static_cast<int32>(RoundedR));
+	}
+
+	FString ToString() const { return FString::Printf(TEXT("Q=%d R=%d S=%d"), Q, R, S()); }
+
+	friend uint32 GetTypeHash(const FHexCoord& Coord)
+	{
+		return HashCombineFast(::GetTypeHash(Coord.Q), ::GetTypeHash(Coord.R));
+	}
+
+	/*
+	 * Allocation free ranges, usable in range based for loops:
+	 *	for (const FHexCoord& Coord : FHexCoord::Ring(Center, 2)) { ... }
+	 */
+	struct FNeighborRange;
+	struct FRingRange;
+	struct FSpiralRange;
+	struct FAreaRange;
+
+	static constexpr FNeighborRange Neighbors(const FHexCoord& Center);
+	static constexpr FRingRange Ring(const FHexCoord& Center, const int32 Radius);
+	static constexpr FSpiralRange Spiral(const FHexCoord& Center, const int32 Radius);
+	static constexpr FAreaRange Area(const FHexCoord& Center, const int32 Radius);
+};
+
+/** The six direct neighbors, in Direction order */
+struct FHexCoord::FNeighborRange
+{
+	struct FIterator
+	{
+		FHexCoord Center;
+		int32 Direction;
+
+		constexpr FHexCoord operator*() const { return Center.Neighbor(Direction); }
+		constexpr FIterator& operator++() { ++Direction; return *this; }
+		constexpr bool operator!=(const FIterator& Other) const { return Direction != Other.Direction; }
+	};
+
+	FHexCoord Center;
+
+	constexpr FIterator begin() const { return FIterator{Center, 0}; }
+	constexpr FIterator end() const { return FIterator{Center, 6}; }
+};
+
+/** All hexes at exactly Radius steps from the center, Radius 0 yields the center itself */
+struct FHexCoord::FRingRange
+{
+	struct FIterator
+	{
+		FHexCoord Current;
+		int32 Radius;
+		int32 Visited;
+
+		constexpr FHexCoord operator*() const { return Current; }
+		constexpr FIterator& operator++()
+		{
+			// Walk Radius steps along each of the six sides, the side is derived from how many hexes were visited
+			if (Radius > 0)
+			{
+				Current = Current.Neighbor(Visited / Radius);
+			}
+			++Visited;
+			return *this;
+		}
+		constexpr bool operator!=(const FIterator& Other) const { return Visited != Other.Visited; }
+	};
+
+	FHexCoord Center;
+	int32 Radius;
+
+	constexpr int32 Num() const { return Radius > 0 ? Radius * 6 : (Radius == 0 ? 1 : 0); }
+
+	constexpr FIterator begin() const { return FIterator{Center + FHexCoord::Direction(4) * Radius, Radius, 0}; }
+	constexpr FIterator end() const { return FIterator{Center, Radius, Num()}; }
+};
+
+/** Center first, then every ring outwards up to and including Radius */
+struct FHexCoord::FSpiralRange
+{
+	struct FIterator
+	{
+		FHexCoord Center;
+		FRingRange::FIterator RingIt;
+		int32 RingNum;
+
+		constexpr FHexCoord operator*() const { return *RingIt; }
+		constexpr FIterator& operator++()
+		{
+			++RingIt;
+			if (RingIt.Visited == RingNum)
+			{
+				const FRingRange NextRing{Center, RingIt.Radius + 1};
+				RingIt = NextRing.begin();
+				RingNum = NextRing.Num();
+			}
+			return *this;
+		}
+		constexpr bool operator!=(const FIterator& Other) const
+		{
+			return RingIt.Radius != Other.RingIt.Radius || RingIt.Visited != Other.RingIt.Visited;
+		}
+	};
+
+	FHexCoord Center;
+	int32 Radius;
+
+	constexpr int32 Num() const { return Radius >= 0 ? 1 + 3 * Radius * (Radius + 1) : 0; }
+
+	constexpr FIterator begin() const
+	{
+		const FRingRange FirstRing{Center, Radius >= 0 ? 0 : Radius + 1};
+		return FIterator{Center, FirstRing.begin(), FirstRing.Num()};
+	}
+	constexpr FIterator end() const
+	{
+		const FRingRange LastRing{Center, Radius + 1};
+		return FIterator{Center, LastRing.begin(), LastRing.Num()};
+	}
+};
+
+/** Every hex within Radius steps of the center in Q-major order, cheaper than a spiral when the order does not matter */
+struct FHexCoord::FAreaRange
+{
+	struct FIterator
+	{
+		FHexCoord Center;
+		int32 Radius;
+		int32 DQ;
+		int32 DR;
+
+		constexpr FHexCoord operator*() const { return Center + FHexCoord(DQ, DR); }
+		constexpr FIterator& operator++()
+		{
+			const int32 MaxR = Radius < Radius - DQ ? Radius : Radius - DQ;
+			if (++DR > MaxR)
+			{
+				++DQ;
+				DR = -Radius > -DQ - Radius ? -Radius : -DQ - Radius;
+			}
+			return *this;
+		}
+		constexpr bool operator!=(const FIterator& Other) const { return DQ != Other.DQ || DR != Other.DR; }
+	};
+
+	FHexCoord Center;
+	int32 Radius;
+
+	constexpr int32 Num() const { return Radius >= 0 ? 1 + 3 * Radius * (Radius + 1) : 0; }
+
+	constexpr FIterator begin() const
+	{
+		return Radius >= 0 ? FIterator{Center, Radius, -Radius, 0} : end();
+	}
+	constexpr FIterator end() const
+	{
+		const int32 EndDQ = Radius >= 0 ? Radius + 1 : 0;
+		return FIterator{Center, Radius, EndDQ, -Radius > -EndDQ - Radius ? -Radius : -EndDQ - Radius};
+	}
+};
+
+constexpr FHexCoord::FNeighborRange FHexCoord::Neighbors(const FHexCoord& Center) { return FNeighborRange{Center}; }
+constexpr FHexCoord::FRingRange FHexCoord::Ring(const FHexCoord& Center, const int32 Radius) { return FRingRange{Center, Radius}; }
+constexpr FHexCoord::FSpiralRange FHexCoord::Spiral(const FHexCoord& Center, const int32 Radius) { return FSpiralRange{Center, Radius}; }
+constexpr FHexCoord::FAreaRange FHexCoord::Area(const FHexCoord& Center, const int32 Radius) { return FAreaRange{Center, Radius}; }
+
+
+/**
+ * Dimensions of a grid, maps hex coordinates to tile indices (Row * Columns + Column) and to the grid actor's local space.
+ * The grid is split into square chunks of ChunkSize x ChunkSize tiles (in Row/Column space), each chunk numbers its own
+ * instances row by row.
+ */
+struct ASYMPTOMAGICKAL_API FHexGridLayout
+{
+	int32 Rows = 0;
+	int32 Columns = 0;
+	float Radius = 50.f;
+	/** Tiles per chunk side, 0 or less puts the whole grid into a single chunk */
+	int32 ChunkSize = 0;
+
+	constexpr FHexGridLayout() = default;
+	constexpr FHexGridLayout(const int32 InRows, const int32 InColumns, const float InRadius, const int32 InChunkSize = 0)
+		: Rows(InRows), Columns(InColumns), Radius(InRadius), ChunkSize(InChunkSize) {}
+
+	constexpr int32 Num() const { return Rows * Columns; }
+
+	constexpr bool IsValidOffset(const int32 Row, const int32 Column) const
+	{
+		return Row >= 0 && Row < Rows && Column >= 0 && Column < Columns;
+	}
+
+	constexpr bool IsValid(const FHexCoord& Coord) const { return IsValidOffset(Coord.GetRow(), Coord.GetColumn()); }
+
+	/** INDEX_NONE for coordinates outside of the grid */
+	constexpr int32 ToTileIndex(const FHexCoord& Coord) const
+	{
+		return IsValid(Coord) ? Coord.GetRow() * Columns + Coord.GetColumn() : INDEX_NONE;
+	}
+
+	constexpr FHexCoord FromTileIndex(const int32 TileIndex) const
+	{
+		return FHexCoord::FromOffset(TileIndex / Columns, TileIndex % Columns);
+	}
+
+	/** Center of the hex in the grid actor's local space */
+	FVector ToLocal(const FHexCoord& Coord, const float Height = 0.f) const
+	{
+		return FVector(Radius * UE_SQRT_3 * (Coord.R + Coord.Q * 0.5f), Radius * 1.5f * Coord.Q, Height);
+	}
+
+	FVector ToLocal(const int32 TileIndex, const float Height = 0.f) const
+	{
+		return ToLocal(FromTileIndex(TileIndex), Height);
+	}
+
+	/** Hex containing a point in the grid actor's local space, Z is ignored */
+	FHexCoord FromLocal(const FVector& Location) const
+	{
+		const double FracQ = Location.Y / (Radius * 1.5);
+		const double FracR = Location.X / (Radius * UE_DOUBLE_SQRT_3) - FracQ * 0.5;
+		return FHexCoord::Round(FracQ, FracR);
+	}
+
+	/** Conservative XY bounds of all tiles in the grid actor's local space */
+	FBox2D GetLocalBounds() const
+	{
+		// Odd columns are shifted by half a row
+		const double MaxX = Radius * UE_DOUBLE_SQRT_3 * (Rows - 1 + (Columns > 1 ? 0.5 : 0.0));
+		const double MaxY = Radius * 1.5 * (Columns - 1);
+		return FBox2D(FVector2D(-Radius, -Radius), FVector2D(MaxX + Radius, MaxY + Radius));
+	}
+
+	/*
+	 *	Chunks
+	 */
+	constexpr int32 GetChunkSize() const
+	{
+		return ChunkSize > 0 ? ChunkSize : (Rows > Columns ? Rows : Columns);
+	}
+
+	constexpr int32 NumChunkRows() const { return GetChunkSize() > 0 ? (Rows + GetChunkSize() - 1) / GetChunkSize() : 0; }
+	constexpr int32 NumChunkColumns() const { return GetChunkSize() > 0 ? (Columns + GetChunkSize() - 1) / GetChunkSize() : 0; }
+	constexpr int32 NumChunks() const { return NumChunkRows() * NumChunkColumns(); }
+
+	constexpr int32 GetChunkIndex(const int32 TileIndex) const
+	{
+		return (TileIndex / Columns) / GetChunkSize() * NumChunkColumns() + (TileIndex % Columns) / GetChunkSize();
+	}
+
+	/** Number of tile columns in the chunk, chunks on the last chunk column can be narrower */
+	constexpr int32 GetChunkWidth(const int32 ChunkIndex) const
+	{
+		const int32 FirstColumn = ChunkIndex % NumChunkColumns() * GetChunkSize();
+		return Columns - FirstColumn < GetChunkSize() ? Columns - FirstColumn : GetChunkSize();
+	}
+
+	constexpr int32 GetChunkHeight(const int32 ChunkIndex) const
+	{
+		const int32 FirstRow = ChunkIndex / NumChunkColumns() * GetChunkSize();
+		return Rows - FirstRow < GetChunkSize() ? Rows - FirstRow : GetChunkSize();
+	}
+
+	constexpr int32 GetChunkNumTiles(const int32 ChunkIndex) const { return GetChunkWidth(ChunkIndex) * GetChunkHeight(ChunkIndex); }
+
+	/** Instance index of the tile inside its chunk's instanced mesh */
+	constexpr int32 GetChunkInstanceIndex(const int32 TileIndex) const
+	{
+		const int32 ChunkIndex = GetChunkIndex(TileIndex);
+		const int32 LocalRow = TileIndex / Columns - ChunkIndex / NumChunkColumns() * GetChunkSize();
+		const int32 LocalColumn = TileIndex % Columns - ChunkIndex % NumChunkColumns() * GetChunkSize();
+		return LocalRow * GetChunkWidth(ChunkIndex) + LocalColumn;
+	}
+
+	constexpr int32 GetTileIndexFromChunkInstance(const int32 ChunkIndex, const int32 InstanceIndex) const
+	{
+		const int32 Row = ChunkIndex / NumChunkColumns() * GetChunkSize() + InstanceIndex / GetChunkWidth(ChunkIndex);
+		const int32 Column = ChunkIndex % NumChunkColumns() * GetChunkSize() + InstanceIndex % GetChunkWidth(ChunkIndex);
+		return Row * Columns + Column;
+	}
+
+	/** Calls Func(Coord, TileIndex) for every hex of the range that lies on the grid */
+	template<typename RangeType, typename FuncType>
+	void ForEachTile(const RangeType& Range, FuncType&& Func) const
+	{
+		for (const FHexCoord Coord : Range)
+		{
+			const int32 TileIndex = ToTileIndex(Coord);
+			if (TileIndex != INDEX_NONE)
+			{
+				Func(Coord, TileIndex);
+			}
+		}
+	}
+};
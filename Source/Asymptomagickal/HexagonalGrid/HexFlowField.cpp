@@ -0,0 +1,133 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexFlowField.h"
+
+#include "HexTileStore.h"
+
+void FHexFlowField::Build(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const int32 InGoalTileIndex, const FHexPathQuery& InQuery)
+{
+	GoalTileIndex = InGoalTileIndex;
+	Query = InQuery;
+
+	Distances.Init(UE_MAX_FLT, Tiles.Num());
+	NextTiles.Init(INDEX_NONE, Tiles.Num());
+	InvalidatedMask.Init(false, Tiles.Num());
+	OpenHeap.Reset();
+
+	if (!Tiles.IsValidIndex(GoalTileIndex) || Tiles.Num() != Layout.Num())
+	{
+		return;
+	}
+
+	Distances[GoalTileIndex] = 0.f;
+	OpenHeap.HeapPush({0.f, GoalTileIndex});
+	Propagate(Layout, Tiles);
+}
+
+void FHexFlowField::Repair(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const TConstArrayView<int32> ChangedTiles)
+{
+	if (Distances.Num() != Tiles.Num() || ChangedTiles.Contains(GoalTileIndex))
+	{
+		Build(Layout, Tiles, GoalTileIndex, Query);
+		return;
+	}
+
+	// Every tile whose route runs through a changed tile lost its distance, that is the subtree below it
+	InvalidatedTiles.Reset();
+	for (const int32 TileIndex : ChangedTiles)
+	{
+		if (Tiles.IsValidIndex(TileIndex) && !InvalidatedMask[TileIndex])
+		{
+			InvalidatedMask[TileIndex] = true;
+			InvalidatedTiles.Add(TileIndex);
+		}
+	}
+
+	for (int32 Cursor = 0; Cursor < InvalidatedTiles.Num(); ++Cursor)
+	{
+		const int32 TileIndex = InvalidatedTiles[Cursor];
+		for (const FHexCoord& Neighbor : FHexCoord::Neighbors(Layout.FromTileIndex(TileIndex)))
+		{
+			const int32 NeighborIndex = Layout.ToTileIndex(Neighbor);
+			if (NeighborIndex != INDEX_NONE && !InvalidatedMask[NeighborIndex] && NextTiles[NeighborIndex] == TileIndex)
+			{
+				InvalidatedMask[NeighborIndex] = true;
+				InvalidatedTiles.Add(NeighborIndex);
+			}
+		}
+	}
+
+	for (const int32 TileIndex : InvalidatedTiles)
+	{
+		Distances[TileIndex] = UE_MAX_FLT;
+		NextTiles[TileIndex] = INDEX_NONE;
+	}
+
+	// Reseed the invalidated region from the intact tiles around it
+	OpenHeap.Reset();
+	for (const int32 TileIndex : InvalidatedTiles)
+	{
+		for (const FHexCoord& Neighbor : FHexCoord::Neighbors(Layout.FromTileIndex(TileIndex)))
+		{
+			const int32 NeighborIndex = Layout.ToTileIndex(Neighbor);
+			if (NeighborIndex == INDEX_NONE || InvalidatedMask[NeighborIndex] || Distances[NeighborIndex] == UE_MAX_FLT
+				|| !FHexPathfinder::CanStep(Tiles, TileIndex, NeighborIndex, Query))
+			{
+				continue;
+			}
+
+			const float Distance = Distances[NeighborIndex] + FHexPathfinder::GetStepCost(Tiles, TileIndex, NeighborIndex, Query);
+			if (Distance < Distances[TileIndex])
+			{
+				Distances[TileIndex] = Distance;
+				NextTiles[TileIndex] = NeighborIndex;
+			}
+		}
+
+		if (Distances[TileIndex] < UE_MAX_FLT)
+		{
+			OpenHeap.HeapPush({Distances[TileIndex], TileIndex});
+		}
+	}
+
+	for (const int32 TileIndex : InvalidatedTiles)
+	{
+		InvalidatedMask[TileIndex] = false;
+	}
+
+	// Also lowers tiles outside the region if a changed tile opened a shorter route
+	Propagate(Layout, Tiles);
+}
+
+void FHexFlowField::Propagate(const FHexGridLayout& Layout, const FHexTileStore& Tiles)
+{
+	while (OpenHeap.Num() > 0)
+	{
+		FOpenNode Node;
+		OpenHeap.HeapPop(Node, EAllowShrinking::No);
+
+		if (Node.Distance > Distances[Node.TileIndex])
+		{
+			continue;
+		}
+
+		// The field is built backwards, so the step checked is the one from the neighbor onto this tile
+		for (const FHexCoord& Neighbor : FHexCoord::Neighbors(Layout.FromTileIndex(Node.TileIndex)))
+		{
+			const int32 NeighborIndex = Layout.ToTileIndex(Neighbor);
+			if (NeighborIndex == INDEX_NONE || !FHexPathfinder::CanStep(Tiles, NeighborIndex, Node.TileIndex, Query))
+			{
+				continue;
+			}
+
+			const float Distance = Node.Distance + FHexPathfinder::GetStepCost(Tiles, NeighborIndex, Node.TileIndex, Query);
+			if (Distance < Distances[NeighborIndex])
+			{
+				Distances[NeighborIndex] = Distance;
+				NextTiles[NeighborIndex] = Node.TileIndex;
+				OpenHeap.HeapPush({Distance, NeighborIndex});
+			}
+		}
+	}
+}
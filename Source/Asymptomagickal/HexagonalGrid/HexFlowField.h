@@ -0,0 +1,59 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexPathfinder.h"
+
+struct FHexGridLayout;
+struct FHexTileStore;
+
+/**
+ * Distance field towards a single goal tile for one kind of agent. Every tile knows its cost to the goal and the neighbor
+ * to step on next, so any number of agents walk to the goal with O(1) lookups.
+ * Tile changes only repair the part of the field whose routes ran through the changed tiles.
+ */
+class ASYMPTOMAGICKAL_API FHexFlowField
+{
+public:
+	/** Computes the whole field */
+	void Build(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const int32 InGoalTileIndex, const FHexPathQuery& InQuery);
+
+	/** Updates the field after the state or height of the tiles changed, duplicates are fine */
+	void Repair(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const TConstArrayView<int32> ChangedTiles);
+
+	/** Neighbor to step on towards the goal, INDEX_NONE at the goal or if the goal cannot be reached */
+	int32 GetNextTile(const int32 TileIndex) const { return NextTiles.IsValidIndex(TileIndex) ? NextTiles[TileIndex] : INDEX_NONE; }
+
+	/** Path cost to the goal, negative if the goal cannot be reached */
+	float GetDistance(const int32 TileIndex) const
+	{
+		return Distances.IsValidIndex(TileIndex) && Distances[TileIndex] < UE_MAX_FLT ? Distances[TileIndex] : -1.f;
+	}
+
+	int32 GetGoalTileIndex() const { return GoalTileIndex; }
+	const FHexPathQuery& GetQuery() const { return Query; }
+
+private:
+	/** Dijkstra outwards from the goal over everything in the open heap */
+	void Propagate(const FHexGridLayout& Layout, const FHexTileStore& Tiles);
+
+	struct FOpenNode
+	{
+		float Distance;
+		int32 TileIndex;
+
+		bool operator<(const FOpenNode& Other) const { return Distance < Other.Distance; }
+	};
+
+	TArray<float> Distances;
+	TArray<int32> NextTiles;
+
+	// Pooled between repairs
+	TArray<FOpenNode> OpenHeap;
+	TArray<int32> InvalidatedTiles;
+	TBitArray<> InvalidatedMask;
+
+	int32 GoalTileIndex = INDEX_NONE;
+	FHexPathQuery Query;
+};
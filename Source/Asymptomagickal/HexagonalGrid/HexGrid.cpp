@@ -3,15 +3,24 @@
 
 #include "HexGrid.h"
 
-#include "Asymptomagickal/AsymGameplayTags.h"
 #include "Asymptomagickal/AsymLogChannels.h"
-#include "Components/InstancedStaticMeshComponent.h"
+#include "HexBoardFile.h"
+#include "HexGridChunk.h"
+#include "HexGridNetStats.h"
+#include "HexInstancedStaticMeshComponent.h"
+#include "HexTileGenerator.h"
+#include "Async/Async.h"
+#include "Async/ParallelFor.h"
+#include "Engine/Engine.h"
+#include "GameFramework/PlayerController.h"
 #include "Net/UnrealNetwork.h"
-
-static float GSqrt3 = FMath::Sqrt(3.f);
+#include "Net/Core/Misc/NetConditionGroupManager.h"
+#include "Net/Core/PushModel/PushModel.h"
 
 #pragma region Editor
 
+// The preview lays out one instance per tile in tile index order on the root ISMC
+
 void AHexGrid::CreateHexGrid() const
 {
 	ISMC->ClearInstances();
@@ -20,67 +29,82 @@ void AHexGrid::CreateHexGrid() const
 		ISMC->SetStaticMesh(HexMesh);
 	}
 	
-	const float Height = Radius * GSqrt3;
+	const FHexGridLayout Layout = GetLayout();
 
-	for (int32 Row = 0; Row < Rows; ++Row)
-	{
-		float XOffset = Height * Row;
+	// Previews exactly what BeginPlay generates, including the generators
+	TArray<float> Heights;
+	TArray<FTileStateBits> States;
+	GenerateTiles(Layout, Heights, States);
 
-		for (int32 Column = 0; Column < Columns; ++Column)
-		{
-			const float YOffset = Radius * 1.5f * Column;
+	TArray<FTransform> Transforms;
+	Transforms.Reserve(Layout.Num());
 
-			FVector Location = Column % 2 == 0 ?
-				FVector(XOffset, YOffset, 0.f) :
-				FVector(Height * 0.5f + XOffset, YOffset, 0.f);
-			
-			int32 InstanceIndex = ISMC->AddInstance(FTransform(Location));
+	for (int32 TileIndex = 0; TileIndex < Layout.Num(); ++TileIndex)
+	{
+		Transforms.Emplace(Layout.ToLocal(TileIndex, Heights[TileIndex]));
+	}
 
-			ISMC->SetCustomDataValue(InstanceIndex, 0, 0); //Custom data will probably be replaced by the gameplaytag container
-		}
+	ISMC->AddInstances(Transforms, false);
+
+	for (int32 TileIndex = 0; TileIndex < Layout.Num(); ++TileIndex)
+	{
+		ISMC->QueueTileCustomData(TileIndex, Heights[TileIndex], States[TileIndex], 0.f);
 	}
+
+	ISMC->FlushPendingUpdates();
 }
 
 void AHexGrid::RaiseRim() const
 {
-	const float Height = Radius * GSqrt3;
+	const FHexGridLayout Layout = GetLayout();
+	const int32 NumInstances = FMath::Min(ISMC->GetInstanceCount(), Layout.Num());
+
+	// Same rule and seeding as the configured Rim generator, else as a Rim generator with its defaults appended to the list
+	const UHexTileGenerator_Rim* RimGenerator = GetDefault<UHexTileGenerator_Rim>();
+	int32 RimGeneratorIndex = Generators.Num();
+	for (int32 GeneratorIndex = 0; GeneratorIndex < Generators.Num(); ++GeneratorIndex)
+	{
+		if (const UHexTileGenerator_Rim* ConfiguredRim = Cast<UHexTileGenerator_Rim>(Generators[GeneratorIndex]))
+		{
+			RimGenerator = ConfiguredRim;
+			RimGeneratorIndex = GeneratorIndex;
+			break;
+		}
+	}
+	const int32 RimSeed = UHexTileGenerator::GetGeneratorSeed(Seed, RimGeneratorIndex);
 	
-	// Raise all hexes on the rim
-	for (int32 InstanceIndex = 0; InstanceIndex < ISMC->GetInstanceCount(); ++InstanceIndex)
+	for (int32 TileIndex = 0; TileIndex < NumInstances; ++TileIndex)
 	{
-		FTransform InstanceTransform;
-		ISMC->GetInstanceTransform(InstanceIndex, InstanceTransform);
-
-		const FVector Location = InstanceTransform.GetLocation();
-		const float X = Location.X;
-		const float Y = Location.Y;
-
-		if (X == 0 || X == Height * (Rows - 1) || Y == 0 || Y == Radius * 1.5f * (Columns - 1) || X == Height * 0.5f || X == Height * 0.5f + Height * (Rows - 1))
+		if (!RimGenerator->IsRimTile(Layout, TileIndex))
 		{
-			// Randomize height
-			const float RandomHeight = FMath::RandRange(2000, 2400);
-			InstanceTransform.SetLocation(FVector(Location.X, Location.Y, RandomHeight));
-			ISMC->UpdateInstanceTransform(InstanceIndex, InstanceTransform);
-			ISMC->SetCustomDataValue(InstanceIndex, 0, RandomHeight);
+			continue;
 		}
+
+		float Height = 0.f;
+		FTileStateBits State = AsymTileState::Default;
+		RimGenerator->GenerateTile(Layout, TileIndex, RimSeed, Height, State);
+
+		ISMC->QueueInstanceTransform(TileIndex, FTransform(Layout.ToLocal(TileIndex, Height)));
+		ISMC->QueueCustomDataValue(TileIndex, UHexInstancedStaticMeshComponent::CustomDataHeight, Height);
 	}
+
+	ISMC->FlushPendingUpdates();
 }
 
 void AHexGrid::RandomizeHeight() const
 {
-	for (int32 InstanceIndex = 0; InstanceIndex < ISMC->GetInstanceCount(); ++InstanceIndex)
-	{
-		FTransform InstanceTransform;
-		ISMC->GetInstanceTransform(InstanceIndex, InstanceTransform);
+	const FHexGridLayout Layout = GetLayout();
+	const int32 NumInstances = FMath::Min(ISMC->GetInstanceCount(), Layout.Num());
 
-		const FVector Location = InstanceTransform.GetLocation();
-		const float RandomHeight = FMath::RandRange(-RandomSpan, RandomSpan);
+	for (int32 TileIndex = 0; TileIndex < NumInstances; ++TileIndex)
+	{
+		const float RandomHeight = UHexTileGenerator::RandomForTile(Seed, TileIndex, -RandomSpan, RandomSpan);
 
-		InstanceTransform.SetLocation(FVector(Location.X, Location.Y, RandomHeight));
-		ISMC->UpdateInstanceTransform(InstanceIndex, InstanceTransform);
-		ISMC->SetCustomDataValue(InstanceIndex, 0, RandomHeight);
+		ISMC->QueueInstanceTransform(TileIndex, FTransform(Layout.ToLocal(TileIndex, RandomHeight)));
+		ISMC->QueueCustomDataValue(TileIndex, UHexInstancedStaticMeshComponent::CustomDataHeight, RandomHeight);
 	}
-	
+
+	ISMC->FlushPendingUpdates();
 }
 
 void AHexGrid::Clear() const
@@ -95,10 +119,9 @@ AHexGrid::AHexGrid()
 {
 	PrimaryActorTick.bCanEverTick = false;
 	SetReplicates(true);
+	bReplicateUsingRegisteredSubObjectList = true;
 
-	TileArray.OwningObject = this;
-
-	ISMC = CreateDefaultSubobject<UInstancedStaticMeshComponent>(TEXT("GridInstancedMesh"));
+	ISMC = CreateDefaultSubobject<UHexInstancedStaticMeshComponent>(TEXT("GridInstancedMesh"));
 	RootComponent = ISMC;
 	if(HexMesh)
 	{
@@ -111,12 +134,10 @@ void AHexGrid::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetime
 {
 	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	// TODO: Benchmark this
 	FDoRepLifetimeParams AHexGridParams;
 	AHexGridParams.bIsPushBased = true;
-	DOREPLIFETIME_WITH_PARAMS_FAST(AHexGrid, TileArray, AHexGridParams);
-	// Or
-	//DOREPLIFETIME(AHexGrid, TileArray);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AHexGrid, Chunks, AHexGridParams);
+	DOREPLIFETIME_WITH_PARAMS_FAST(AHexGrid, GridParams, AHexGridParams);
 }
 
 void AHexGrid::BeginPlay()
@@ -127,38 +148,277 @@ void AHexGrid::BeginPlay()
 
 	InitInstancesLocally();
 
+	if (!HasAuthority())
+	{
+		CheckBoardSnapshot();
+	}
+
 	InitializeHexGrid();
 }
 
-void AHexGrid::InitInstancesLocally()
+void AHexGrid::EndPlay(const EEndPlayReason::Type EndPlayReason)
 {
-	if(HasAuthority())
+	if (HasAuthority())
 	{
-		TileArray.Items.Empty();
+		RemoveChunkNetGroups();
 	}
-	
-	ISMC->ClearInstances();
-	
-	for (int32 Row = 0; Row < Rows; ++Row)
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AHexGrid::OnRep_GridParams()
+{
+	const bool bParamsChanged = Rows != GridParams.Rows || Columns != GridParams.Columns || Radius != GridParams.Radius
+		|| RandomSpan != GridParams.RandomSpan || Seed != GridParams.Seed || ChunkSize != GridParams.ChunkSize
+		|| BoardSnapshotFile != GridParams.BoardSnapshotFile
+		|| (bLoadedSnapshot && BoardSnapshotChecksum != GridParams.BoardSnapshotChecksum);
+
+	Rows = GridParams.Rows;
+	Columns = GridParams.Columns;
+	Radius = GridParams.Radius;
+	RandomSpan = GridParams.RandomSpan;
+	Seed = GridParams.Seed;
+	ChunkSize = GridParams.ChunkSize;
+	BoardSnapshotFile = GridParams.BoardSnapshotFile;
+
+	// Before BeginPlay the grid gets built and checked with these values anyway
+	if (!HasActorBegunPlay())
+	{
+		return;
+	}
+
+	if (bParamsChanged)
+	{
+		InitInstancesLocally();
+	}
+	CheckBoardSnapshot();
+}
+
+void AHexGrid::CheckBoardSnapshot()
+{
+	if (GridParams.BoardSnapshotFile.IsEmpty())
+	{
+		return;
+	}
+
+	if (bLoadedSnapshot && BoardSnapshotChecksum == GridParams.BoardSnapshotChecksum)
+	{
+		return;
+	}
+
+	const FString Message = bLoadedSnapshot
+		? FString::Printf(TEXT("Board snapshot %s differs from the server's"), *GridParams.BoardSnapshotFile)
+		: FString::Printf(TEXT("Board snapshot %s of the server could not be loaded"), *GridParams.BoardSnapshotFile);
+	UE_LOG(LogAsym, Error, TEXT("%s, leaving the game"), *Message);
+
+	// Playing on with a different board would desync every tile the server does not replicate
+	if (UNetDriver* NetDriver = GetNetDriver())
+	{
+		GEngine->BroadcastNetworkFailure(GetWorld(), NetDriver, ENetworkFailure::OutdatedClient, Message);
+	}
+}
+
+void AHexGrid::InitTiles()
+{
+	if (!BoardSnapshotFile.IsEmpty())
+	{
+		FHexGridLayout SnapshotLayout = GetLayout();
+		FHexTileStore SnapshotTiles;
+		uint32 Checksum = 0;
+		if (FHexBoardFile::Load(BoardSnapshotFile, SnapshotLayout, SnapshotTiles, Checksum))
+		{
+			UseBoardSnapshot(SnapshotLayout, SnapshotTiles, Checksum);
+			return;
+		}
+
+		UE_LOG(LogAsym, Warning, TEXT("Generating the grid, board snapshot %s could not be loaded"), *BoardSnapshotFile);
+	}
+
+	bLoadedSnapshot = false;
+	BoardSnapshotChecksum = 0;
+
+	// Every machine generates the default board itself, the replicated chunks only patch it
+	TArray<float> Heights;
+	TArray<FTileStateBits> States;
+	GenerateTiles(GetLayout(), Heights, States);
+	TileStore.Init(Heights, States);
+	BaseTiles = TileStore;
+}
+
+void AHexGrid::UseBoardSnapshot(const FHexGridLayout& SnapshotLayout, const FHexTileStore& SnapshotTiles, const uint32 Checksum)
+{
+	Rows = SnapshotLayout.Rows;
+	Columns = SnapshotLayout.Columns;
+	Radius = SnapshotLayout.Radius;
+
+	// The store's version restarts with the copy, a cached snapshot could carry the same version
+	TileStore = SnapshotTiles;
+	CachedSnapshot.Reset();
+	BaseTiles = TileStore;
+
+	bLoadedSnapshot = true;
+	BoardSnapshotChecksum = Checksum;
+}
+
+void AHexGrid::InitInstancesLocally()
+{
+	InitTiles();
+	BuildInstances();
+}
+
+void AHexGrid::BuildInstances()
+{
+	const FHexGridLayout Layout = GetLayout();
+
+	// Instances of a chunk are laid out row by row, see FHexGridLayout::GetChunkInstanceIndex
+	TArray<TArray<FTransform>> ChunkTransforms;
+	ChunkTransforms.SetNum(Layout.NumChunks());
+	ParallelFor(Layout.NumChunks(), [this, &Layout, &ChunkTransforms](const int32 ChunkIndex)
 	{
-		for (int32 Column = 0; Column < Columns; ++Column)
+		TArray<FTransform>& Transforms = ChunkTransforms[ChunkIndex];
+		Transforms.Reserve(Layout.GetChunkNumTiles(ChunkIndex));
+
+		for (int32 InstanceIndex = 0; InstanceIndex < Layout.GetChunkNumTiles(ChunkIndex); ++InstanceIndex)
 		{
-			const int32 InstanceIndex = ISMC->AddInstance(FTransform());
+			const int32 TileIndex = Layout.GetTileIndexFromChunkInstance(ChunkIndex, InstanceIndex);
+			Transforms.Emplace(Layout.ToLocal(TileIndex, TileStore.GetHeight(TileIndex)));
+		}
+	});
 
-			if (HasAuthority())
-			{
-				FTileData NewTile;
-				NewTile.TileIndex = InstanceIndex;
-				NewTile.HexCoordinates = FVector(0.f, 0.f, 0.f);
-				NewTile.GameplayTags.AddTag(AsymGameplayTags::Tile_Permission_All);
-				TileArray.Items.Add(NewTile);
-			}
+	// The root ISMC only holds the editor preview, at runtime the chunk meshes render the grid
+	ISMC->ClearInstances();
+	CreateChunkMeshes(Layout);
+
+	for (int32 ChunkIndex = 0; ChunkIndex < Layout.NumChunks(); ++ChunkIndex)
+	{
+		const TArray<FTransform>& Transforms = ChunkTransforms[ChunkIndex];
+
+		UHexInstancedStaticMeshComponent* ChunkMesh = ChunkMeshes[ChunkIndex];
+		ChunkMesh->AddInstances(Transforms, false);
+
+		for (int32 InstanceIndex = 0; InstanceIndex < Transforms.Num(); ++InstanceIndex)
+		{
+			const int32 TileIndex = Layout.GetTileIndexFromChunkInstance(ChunkIndex, InstanceIndex);
+			ChunkMesh->QueueTileCustomData(InstanceIndex, TileStore.GetHeight(TileIndex), TileStore.GetState(TileIndex), 0.f);
 		}
 	}
 
+	if (!HasAuthority())
+	{
+		ApplyReplicatedChunks();
+	}
+
+	for (UHexInstancedStaticMeshComponent* ChunkMesh : ChunkMeshes)
+	{
+		ChunkMesh->FlushPendingUpdates();
+	}
+
+	++HeightVersion;
+
+	FlowFieldDirtyTiles.Reset();
+	for (TPair<int32, FHexFlowField>& FlowField : FlowFields)
+	{
+		FlowField.Value.Build(Layout, TileStore, FlowField.Value.GetGoalTileIndex(), FlowField.Value.GetQuery());
+	}
+
 	UE_LOG(LogAsym, Log, TEXT("Initialized Instances Locally"));
 }
 
+void AHexGrid::CreateChunkMeshes(const FHexGridLayout& Layout)
+{
+	for (UHexInstancedStaticMeshComponent* ChunkMesh : ChunkMeshes)
+	{
+		if (ChunkMesh)
+		{
+			ChunkMesh->DestroyComponent();
+		}
+	}
+	ChunkMeshes.Reset(Layout.NumChunks());
+
+	UStaticMesh* Mesh = HexMesh ? HexMesh : ISMC->GetStaticMesh();
+	TileTopOffset = Mesh ? Mesh->GetBounds().GetBox().Max.Z : 0.f;
+
+	for (int32 ChunkIndex = 0; ChunkIndex < Layout.NumChunks(); ++ChunkIndex)
+	{
+		UHexInstancedStaticMeshComponent* ChunkMesh = NewObject<UHexInstancedStaticMeshComponent>(this, NAME_None, RF_Transient);
+		ChunkMesh->ChunkIndex = ChunkIndex;
+		ChunkMesh->SetStaticMesh(Mesh);
+		for (int32 MaterialIndex = 0; MaterialIndex < ISMC->GetNumMaterials(); ++MaterialIndex)
+		{
+			ChunkMesh->SetMaterial(MaterialIndex, ISMC->GetMaterial(MaterialIndex));
+		}
+		ChunkMesh->SetCollisionProfileName(ISMC->GetCollisionProfileName());
+		if (!bEnableInstanceCollision)
+		{
+			ChunkMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		}
+		ChunkMesh->SetupAttachment(ISMC);
+		ChunkMesh->RegisterComponent();
+
+		ChunkMeshes.Add(ChunkMesh);
+	}
+}
+
+void AHexGrid::ApplyReplicatedChunks()
+{
+	for (const UHexGridChunk* Chunk : Chunks)
+	{
+		// Chunk references can arrive before their subobjects resolved
+		if (!Chunk)
+		{
+			continue;
+		}
+
+		for (const FTileData& Tile : Chunk->TileArray.Items)
+		{
+			ApplyTile(Tile);
+		}
+	}
+}
+
+void AHexGrid::OnRep_Chunks()
+{
+	if (TileStore.Num() == 0)
+	{
+		return;
+	}
+
+	ApplyReplicatedChunks();
+
+	for (UHexInstancedStaticMeshComponent* ChunkMesh : ChunkMeshes)
+	{
+		ChunkMesh->FlushPendingUpdates();
+	}
+}
+
+void AHexGrid::RestoreChunk(const UHexGridChunk& Chunk)
+{
+	const FHexGridLayout Layout = GetLayout();
+	UHexInstancedStaticMeshComponent* ChunkMesh = GetChunkMesh(Chunk.GetChunkIndex());
+	if (!ChunkMesh || TileStore.Num() != Layout.Num())
+	{
+		// Not built yet, InitInstancesLocally applies the chunk
+		return;
+	}
+
+	for (int32 InstanceIndex = 0; InstanceIndex < Layout.GetChunkNumTiles(Chunk.GetChunkIndex()); ++InstanceIndex)
+	{
+		ApplyTile(MakeDefaultTile(Layout.GetTileIndexFromChunkInstance(Chunk.GetChunkIndex(), InstanceIndex)));
+	}
+
+	for (const FTileData& Tile : Chunk.TileArray.Items)
+	{
+		ApplyTile(Tile);
+	}
+
+	ChunkMesh->FlushPendingUpdates();
+}
+
+UHexInstancedStaticMeshComponent* AHexGrid::GetChunkMesh(const int32 ChunkIndex) const
+{
+	return ChunkMeshes.IsValidIndex(ChunkIndex) ? ChunkMeshes[ChunkIndex].Get() : nullptr;
+}
+
 void AHexGrid::InitializeHexGrid()
 {
 	if (!HasAuthority())
@@ -166,103 +426,962 @@ void AHexGrid::InitializeHexGrid()
 		return;
 	}
 
-	// Go over the tile array and set the positions of the instances to a grid and then dirty the array
+	// Filled after the tiles were set up, a board snapshot overrides the dimensions
+	GridParams.Rows = Rows;
+	GridParams.Columns = Columns;
+	GridParams.Radius = Radius;
+	GridParams.RandomSpan = RandomSpan;
+	GridParams.Seed = Seed;
+	GridParams.ChunkSize = ChunkSize;
+	GridParams.BoardSnapshotFile = bLoadedSnapshot ? BoardSnapshotFile : FString();
+	GridParams.BoardSnapshotChecksum = BoardSnapshotChecksum;
+	MARK_PROPERTY_DIRTY_FROM_NAME(AHexGrid, GridParams, this);
+
+	Journal.Init(JournalCapacity, TileStore);
+	UndoScratch.Reset(JournalCapacity);
+
+	RemoveChunkNetGroups();
+
+	for (UHexGridChunk* Chunk : Chunks)
+	{
+		RemoveReplicatedSubObject(Chunk);
+	}
+	Chunks.Reset();
+
+	const FHexGridLayout Layout = GetLayout();
+	const bool bFilterChunks = ChunkRelevancyDistance > 0.f;
 
-	for (int32 i = 0; i < TileArray.Items.Num(); ++i)
+	for (int32 ChunkIndex = 0; ChunkIndex < Layout.NumChunks(); ++ChunkIndex)
 	{
-		const FTileData& Tile = TileArray.Items[i];
-		const int32 InstanceIndex = Tile.TileIndex;
+		UHexGridChunk* Chunk = NewObject<UHexGridChunk>(this);
+		Chunk->InitChunk(ChunkIndex);
 
-		const int32 Row = i / Columns;
-		const int32 Column = i % Columns;
+		if (bFilterChunks)
+		{
+			// Iris only replicates COND_NetGroup subobjects to connections whose controller is a member of the group
+			const FName NetGroup(*FString::Printf(TEXT("%s_Chunk"), *GetName()), ChunkIndex + 1);
+			UE::Net::FNetConditionGroupManager::RegisterSubObjectInGroup(Chunk, NetGroup);
+			AddReplicatedSubObject(Chunk, COND_NetGroup);
+			ChunkNetGroups.Add(NetGroup);
+		}
+		else
+		{
+			AddReplicatedSubObject(Chunk);
+		}
 
-		const float Height = Radius * GSqrt3;
-		const float XOffset = Height * Row;
-		const float YOffset = Radius * 1.5f * Column;
+		Chunks.Add(Chunk);
+	}
+	MARK_PROPERTY_DIRTY_FROM_NAME(AHexGrid, Chunks, this);
 
-		FVector_NetQuantize Location = Column % 2 == 0 ?
-			FVector(XOffset, YOffset, 0.f) :
-			FVector(Height * 0.5f + XOffset, YOffset, 0.f);
+	if (bFilterChunks)
+	{
+		ChunkBounds.Init(FBox2D(ForceInit), Layout.NumChunks());
+		for (int32 TileIndex = 0; TileIndex < Layout.Num(); ++TileIndex)
+		{
+			ChunkBounds[Layout.GetChunkIndex(TileIndex)] += FVector2D(Layout.ToLocal(TileIndex, 0.f));
+		}
+		for (FBox2D& Bounds : ChunkBounds)
+		{
+			Bounds = Bounds.ExpandBy(Radius);
+		}
 
-		FTransform InstanceTransform;
-		InstanceTransform.SetLocation(Location);
-		ISMC->UpdateInstanceTransform(InstanceIndex, InstanceTransform);
+		UpdateChunkRelevancy();
+		GetWorldTimerManager().SetTimer(ChunkRelevancyTimerHandle, this, &AHexGrid::UpdateChunkRelevancy, ChunkRelevancyUpdateInterval, true);
+	}
 
-		TileArray.Items[i].HexCoordinates = Location;
+	if (!bReplicateSparseTiles)
+	{
+		for (int32 TileIndex = 0; TileIndex < TileStore.Num(); ++TileIndex)
+		{
+			Chunks[Layout.GetChunkIndex(TileIndex)]->TileArray.AddTile(GetTileFromIndex(TileIndex));
+		}
 	}
 
-	TileArray.MarkArrayDirty();
+	for (UHexGridChunk* Chunk : Chunks)
+	{
+		Chunk->TileArray.MarkArrayDirty();
+	}
 
 	UE_LOG(LogAsym, Log, TEXT("Initialized HexGrid on Server"));
 }
 
-
-FTileData AHexGrid::GetTileDataFromItem(const int32 Item)
+void AHexGrid::RemoveChunkNetGroups()
 {
-	return GetTileFromIndex(Item);
-}
+	GetWorldTimerManager().ClearTimer(ChunkRelevancyTimerHandle);
+	ChunkBounds.Reset();
 
-void AHexGrid::SetTagsOnTile(const int32 TileIndex, const FGameplayTagContainer& NewTags)
-{
-	if(!HasAuthority())
+	if (ChunkNetGroups.IsEmpty())
 	{
-		UE_LOG(LogAsym, Error, TEXT("SetTagsOnTile cannot be called on client"));
 		return;
 	}
-	
-	for (FTileData& Tile : TileArray.Items)
+
+	for (int32 ChunkIndex = 0; ChunkIndex < ChunkNetGroups.Num(); ++ChunkIndex)
 	{
-		if (Tile == TileIndex)
+		if (Chunks.IsValidIndex(ChunkIndex) && Chunks[ChunkIndex])
 		{
-			Tile.GameplayTags = NewTags;
-			TileArray.MarkItemDirty(Tile);
-			return;
+			UE::Net::FNetConditionGroupManager::UnregisterSubObjectFromGroup(Chunks[ChunkIndex], ChunkNetGroups[ChunkIndex]);
 		}
 	}
 
-	UE_LOG(LogAsym, Warning, TEXT("Tile with index %d not found"), TileIndex);
-}
+	// Group names are reused by the next build, stale memberships would make the new chunks relevant right away
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		APlayerController* PlayerController = It->Get();
+		if (!PlayerController)
+		{
+			continue;
+		}
 
+		for (const FName& NetGroup : ChunkNetGroups)
+		{
+			if (PlayerController->IsMemberOfNetConditionGroup(NetGroup))
+			{
+				PlayerController->RemoveFromNetConditionGroup(NetGroup);
+			}
+		}
+	}
 
+	ChunkNetGroups.Reset();
+}
 
-FTileData AHexGrid::GetTileFromIndex(const int32 Index) const
+void AHexGrid::UpdateChunkRelevancy()
 {
-	for (const FTileData& Tile : TileArray.Items)
+	const double RelevancyDistanceSquared = FMath::Square(ChunkRelevancyDistance);
+	const FTransform& GridTransform = GetActorTransform();
+
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
 	{
-		if (Tile == Index)
+		APlayerController* PlayerController = It->Get();
+		// The listen server host sees the authoritative grid anyway
+		if (!PlayerController || PlayerController->IsLocalController())
+		{
+			continue;
+		}
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+		const FVector2D LocalViewLocation(GridTransform.InverseTransformPosition(ViewLocation));
+
+		for (int32 ChunkIndex = 0; ChunkIndex < ChunkNetGroups.Num(); ++ChunkIndex)
 		{
-			return Tile;
+			const bool bRelevant = ChunkBounds[ChunkIndex].ComputeSquaredDistanceToPoint(LocalViewLocation) <= RelevancyDistanceSquared;
+			if (bRelevant == PlayerController->IsMemberOfNetConditionGroup(ChunkNetGroups[ChunkIndex]))
+			{
+				continue;
+			}
+
+			if (bRelevant)
+			{
+				PlayerController->IncludeInNetConditionGroup(ChunkNetGroups[ChunkIndex]);
+			}
+			else
+			{
+				PlayerController->RemoveFromNetConditionGroup(ChunkNetGroups[ChunkIndex]);
+			}
 		}
 	}
+}
+
+
+void AHexGrid::UpdateTileInstance(const FTileData& Tile) const
+{
+	const FHexGridLayout Layout = GetLayout();
+
+	UHexInstancedStaticMeshComponent* ChunkMesh = GetChunkMesh(Layout.GetChunkIndex(Tile.TileIndex));
+	if (!ChunkMesh)
+	{
+		return;
+	}
 
-	UE_LOG(LogAsym, Warning, TEXT("Tile with index %d not found"), Index);
-	return FTileData();
+	const int32 InstanceIndex = Layout.GetChunkInstanceIndex(Tile.TileIndex);
+	if (bStaticInstanceTransforms)
+	{
+		// Instances were built at the base height, see InitInstancesLocally
+		ChunkMesh->QueueTileCustomData(InstanceIndex, Tile.Height, Tile.StateBits, Tile.Height - BaseTiles.GetHeight(Tile.TileIndex));
+	}
+	else
+	{
+		ChunkMesh->QueueInstanceTransform(InstanceIndex, FTransform(Layout.ToLocal(Tile.TileIndex, Tile.Height)));
+		ChunkMesh->QueueTileCustomData(InstanceIndex, Tile.Height, Tile.StateBits, 0.f);
+	}
 }
 
+void AHexGrid::ApplyTile(const FTileData& Tile)
+{
+	if (!TileStore.IsValidIndex(Tile.TileIndex))
+	{
+		return;
+	}
 
+	const bool bHeightChanged = TileStore.GetHeight(Tile.TileIndex) != Tile.Height;
+	if (bHeightChanged)
+	{
+		++HeightVersion;
+	}
 
-#pragma region FTileData
+	if (FlowFields.Num() > 0 && (bHeightChanged || TileStore.GetState(Tile.TileIndex) != Tile.StateBits))
+	{
+		FlowFieldDirtyTiles.Add(Tile.TileIndex);
+		if (!bFlowFieldUpdateScheduled)
+		{
+			bFlowFieldUpdateScheduled = true;
+			GetWorldTimerManager().SetTimerForNextTick(this, &AHexGrid::UpdateFlowFields);
+		}
+	}
 
-// TODO: Try to find a way to Bulk call this function if the bandwith gets too intense with many modifications simultaniously
-void FTileData::PostReplicatedAdd(const FTileDataArray& InArraySerializer)
+	TileStore.SetHeight(Tile.TileIndex, Tile.Height);
+	TileStore.SetState(Tile.TileIndex, Tile.StateBits);
+	UpdateTileInstance(Tile);
+}
+
+FTileData AHexGrid::MakeDefaultTile(const int32 TileIndex) const
 {
-	AHexGrid* HexGrid = Cast<AHexGrid>(InArraySerializer.OwningObject);
-	if (HexGrid && HexGrid->ISMC)
+	if (!BaseTiles.IsValidIndex(TileIndex))
 	{
-		FTransform InstanceTransform;
-		InstanceTransform.SetLocation(HexCoordinates);
-		HexGrid->ISMC->UpdateInstanceTransform(TileIndex, InstanceTransform);
+		return GenerateTile(TileIndex);
+	}
 
-		UE_LOG(LogAsym, Log, TEXT("PostReplicatedAdd %s"), *HexCoordinates.ToString());
+	FTileData Tile;
+	Tile.TileIndex = TileIndex;
+	Tile.StateBits = BaseTiles.GetState(TileIndex);
+	Tile.SetHeight(BaseTiles.GetHeight(TileIndex));
+
+	return Tile;
+}
+
+FTileData AHexGrid::GenerateTile(const int32 TileIndex) const
+{
+	// Seeded per tile so the result does not depend on the order tiles are generated in
+	float Height = UHexTileGenerator::RandomForTile(Seed, TileIndex, -RandomSpan, RandomSpan);
+	FTileStateBits State = AsymTileState::Default;
+
+	const FHexGridLayout Layout = GetLayout();
+	for (int32 GeneratorIndex = 0; GeneratorIndex < Generators.Num(); ++GeneratorIndex)
+	{
+		if (const UHexTileGenerator* Generator = Generators[GeneratorIndex])
+		{
+			Generator->GenerateTile(Layout, TileIndex, UHexTileGenerator::GetGeneratorSeed(Seed, GeneratorIndex), Height, State);
+		}
 	}
+
+	FTileData Tile;
+	Tile.TileIndex = TileIndex;
+	Tile.StateBits = State;
+	Tile.SetHeight(Height);
+
+	return Tile;
 }
 
-void FTileData::PreReplicatedRemove(const struct FTileDataArray& InArraySerializer)
+void AHexGrid::GenerateTiles(const FHexGridLayout& Layout, TArray<float>& OutHeights, TArray<FTileStateBits>& OutStates) const
 {
+	OutHeights.SetNumUninitialized(Layout.Num());
+	OutStates.SetNumUninitialized(Layout.Num());
+
+	// Generation only reads settings, every chunk writes its own tiles
+	ParallelFor(Layout.NumChunks(), [this, &Layout, &OutHeights, &OutStates](const int32 ChunkIndex)
+	{
+		for (int32 InstanceIndex = 0; InstanceIndex < Layout.GetChunkNumTiles(ChunkIndex); ++InstanceIndex)
+		{
+			const int32 TileIndex = Layout.GetTileIndexFromChunkInstance(ChunkIndex, InstanceIndex);
+			const FTileData Tile = GenerateTile(TileIndex);
+			OutHeights[TileIndex] = Tile.Height;
+			OutStates[TileIndex] = Tile.StateBits;
+		}
+	});
 }
 
-void FTileData::PostReplicatedChange(const struct FTileDataArray& InArraySerializer)
+FHexCoord AHexGrid::GetTileCoord(const int32 TileIndex) const
 {
+	return GetLayout().FromTileIndex(TileIndex);
+}
+
+int32 AHexGrid::GetTileIndexFromCoord(const FHexCoord& Coord) const
+{
+	return GetLayout().ToTileIndex(Coord);
+}
+
+void AHexGrid::GetTilesInRange(const int32 CenterTileIndex, const int32 Range, TArray<int32>& OutTileIndices) const
+{
+	OutTileIndices.Reset();
+
+	const FHexGridLayout Layout = GetLayout();
+	if (CenterTileIndex < 0 || CenterTileIndex >= Layout.Num())
+	{
+		return;
+	}
+
+	const FHexCoord::FSpiralRange Spiral = FHexCoord::Spiral(Layout.FromTileIndex(CenterTileIndex), Range);
+	OutTileIndices.Reserve(Spiral.Num());
+
+	Layout.ForEachTile(Spiral, [&OutTileIndices](const FHexCoord&, const int32 TileIndex)
+	{
+		OutTileIndices.Add(TileIndex);
+	});
+}
+
+bool AHexGrid::FindPath(const int32 StartTileIndex, const int32 GoalTileIndex, const FHexPathQuery& Query, TArray<int32>& OutPath)
+{
+	return Pathfinder.FindPath(GetLayout(), TileStore, StartTileIndex, GoalTileIndex, Query, OutPath);
+}
+
+bool AHexGrid::CanAgentEnterTile(const int32 TileIndex, const EHexPathAgent Agent) const
+{
+	return TileStore.IsValidIndex(TileIndex) && FHexPathfinder::CanEnter(TileStore.GetState(TileIndex), Agent);
+}
+
+void AHexGrid::GetVisibleTiles(const int32 ObserverTileIndex, const int32 Range, const float EyeHeight, TArray<int32>& OutTileIndices)
+{
+	// Observers rarely move every frame, but any height change can open or block sight anywhere
+	static constexpr int32 MaxCachedFieldsOfView = 256;
+	if (FieldOfViewCacheVersion != HeightVersion || FieldOfViewCache.Num() >= MaxCachedFieldsOfView)
+	{
+		FieldOfViewCache.Reset();
+		FieldOfViewCacheVersion = HeightVersion;
+	}
+
+	const FFieldOfViewKey Key{ObserverTileIndex, Range, FTileData::QuantizeHeight(EyeHeight)};
+	if (const TArray<int32>* CachedTiles = FieldOfViewCache.Find(Key))
+	{
+		OutTileIndices = *CachedTiles;
+		return;
+	}
+
+	Visibility.ComputeFieldOfView(GetLayout(), TileStore, ObserverTileIndex, Range, EyeHeight, OutTileIndices);
+	FieldOfViewCache.Add(Key, OutTileIndices);
+}
+
+bool AHexGrid::HasLineOfSight(const int32 FromTileIndex, const int32 ToTileIndex, const float EyeHeight) const
+{
+	return FHexVisibility::HasLineOfSight(GetLayout(), TileStore, FromTileIndex, ToTileIndex, EyeHeight);
+}
+
+FHexGridSnapshotRef AHexGrid::GetSnapshot() const
+{
+	if (!CachedSnapshot.IsValid() || CachedSnapshot->Version != TileStore.GetVersion())
+	{
+		// Copying the store only adds a reference to each tile block, blocks are copied when the grid writes to them next
+		const TSharedRef<FHexGridSnapshot, ESPMode::ThreadSafe> Snapshot = MakeShared<FHexGridSnapshot, ESPMode::ThreadSafe>();
+		Snapshot->Layout = GetLayout();
+		Snapshot->Tiles = TileStore;
+		Snapshot->Version = TileStore.GetVersion();
+		CachedSnapshot = Snapshot;
+	}
+
+	return CachedSnapshot.ToSharedRef();
+}
+
+bool AHexGrid::SaveBoardSnapshot(const FString& FilePath) const
+{
+	if (!HasAuthority())
+	{
+		return false;
+	}
+
+	return FHexBoardFile::Save(FilePath, GetLayout(), TileStore);
+}
+
+bool AHexGrid::LoadBoardSnapshot(const FString& FilePath)
+{
+	if (!HasAuthority())
+	{
+		return false;
+	}
+
+	// Checked up front so a bad file leaves the running board alone instead of falling back to the generation
+	FHexGridLayout SnapshotLayout;
+	FHexTileStore SnapshotTiles;
+	uint32 Checksum = 0;
+	if (!FHexBoardFile::Load(FilePath, SnapshotLayout, SnapshotTiles, Checksum))
+	{
+		return false;
+	}
+
+	BoardSnapshotFile = FilePath;
+	UseBoardSnapshot(SnapshotLayout, SnapshotTiles, Checksum);
+	BuildInstances();
+	InitializeHexGrid();
+
+	return true;
+}
+
+/** Every worker thread keeps its own pooled search state */
+static FHexPathfinder& GetWorkerPathfinder()
+{
+	static thread_local FHexPathfinder WorkerPathfinder;
+	return WorkerPathfinder;
+}
+
+TFuture<FHexGridQueryResult> AHexGrid::FindPathAsync(const int32 StartTileIndex, const int32 GoalTileIndex, const FHexPathQuery& Query) const
+{
+	return Async(EAsyncExecution::TaskGraph, [Snapshot = GetSnapshot(), StartTileIndex, GoalTileIndex, Query]()
+	{
+		FHexGridQueryResult Result;
+		Result.SnapshotVersion = static_cast<int32>(Snapshot->Version);
+		Result.bSuccess = GetWorkerPathfinder().FindPath(Snapshot->Layout, Snapshot->Tiles, StartTileIndex, GoalTileIndex, Query, Result.TileIndices);
+		return Result;
+	});
+}
+
+TFuture<FHexGridQueryResult> AHexGrid::FindReachableTilesAsync(const int32 StartTileIndex, const float MaxCost, const FHexPathQuery& Query) const
+{
+	return Async(EAsyncExecution::TaskGraph, [Snapshot = GetSnapshot(), StartTileIndex, MaxCost, Query]()
+	{
+		FHexGridQueryResult Result;
+		Result.SnapshotVersion = static_cast<int32>(Snapshot->Version);
+		GetWorkerPathfinder().FindReachable(Snapshot->Layout, Snapshot->Tiles, StartTileIndex, MaxCost, Query, Result.TileIndices);
+		Result.bSuccess = Result.TileIndices.Num() > 0;
+		return Result;
+	});
+}
+
+TFuture<FHexGridQueryResult> AHexGrid::FindTilesInRangeAsync(const int32 CenterTileIndex, const int32 Range, const FHexPathQuery& Query) const
+{
+	return Async(EAsyncExecution::TaskGraph, [Snapshot = GetSnapshot(), CenterTileIndex, Range, Query]()
+	{
+		FHexGridQueryResult Result;
+		Result.SnapshotVersion = static_cast<int32>(Snapshot->Version);
+
+		const FHexGridLayout& Layout = Snapshot->Layout;
+		if (!Snapshot->Tiles.IsValidIndex(CenterTileIndex))
+		{
+			return Result;
+		}
+
+		const FHexCoord::FSpiralRange Spiral = FHexCoord::Spiral(Layout.FromTileIndex(CenterTileIndex), Range);
+		Result.TileIndices.Reserve(Spiral.Num());
+
+		Layout.ForEachTile(Spiral, [&Result, &Snapshot, &Query](const FHexCoord&, const int32 TileIndex)
+		{
+			if (FHexPathfinder::CanEnter(Snapshot->Tiles.GetState(TileIndex), Query.Agent))
+			{
+				Result.TileIndices.Add(TileIndex);
+			}
+		});
+
+		Result.bSuccess = true;
+		return Result;
+	});
+}
+
+int32 AHexGrid::RegisterFlowFieldGoal(const int32 GoalTileIndex, const FHexPathQuery& Query)
+{
+	if (!TileStore.IsValidIndex(GoalTileIndex))
+	{
+		UE_LOG(LogAsym, Warning, TEXT("Tile with index %d not found"), GoalTileIndex);
+		return INDEX_NONE;
+	}
+
+	// Repair the existing fields first, the new one is built from the current tiles
+	UpdateFlowFields();
+
+	const int32 FlowFieldId = NextFlowFieldId++;
+	FlowFields.Add(FlowFieldId).Build(GetLayout(), TileStore, GoalTileIndex, Query);
+	return FlowFieldId;
+}
+
+void AHexGrid::UnregisterFlowFieldGoal(const int32 FlowFieldId)
+{
+	FlowFields.Remove(FlowFieldId);
+}
+
+int32 AHexGrid::GetFlowFieldNextTile(const int32 FlowFieldId, const int32 TileIndex)
+{
+	UpdateFlowFields();
+
+	const FHexFlowField* FlowField = FlowFields.Find(FlowFieldId);
+	return FlowField ? FlowField->GetNextTile(TileIndex) : INDEX_NONE;
+}
+
+float AHexGrid::GetFlowFieldDistance(const int32 FlowFieldId, const int32 TileIndex)
+{
+	UpdateFlowFields();
+
+	const FHexFlowField* FlowField = FlowFields.Find(FlowFieldId);
+	return FlowField ? FlowField->GetDistance(TileIndex) : -1.f;
+}
+
+void AHexGrid::UpdateFlowFields()
+{
+	bFlowFieldUpdateScheduled = false;
+
+	if (FlowFieldDirtyTiles.IsEmpty())
+	{
+		return;
+	}
+
+	const FHexGridLayout Layout = GetLayout();
+	for (TPair<int32, FHexFlowField>& FlowField : FlowFields)
+	{
+		FlowField.Value.Repair(Layout, TileStore, FlowFieldDirtyTiles);
+	}
+
+	FlowFieldDirtyTiles.Reset();
+}
+
+FTileData AHexGrid::GetTileDataFromItem(const int32 Item)
+{
+	return GetTileFromIndex(Item);
+}
+
+void AHexGrid::SetTagsOnTile(const int32 TileIndex, const FGameplayTagContainer& NewTags)
+{
+	if(!HasAuthority())
+	{
+		UE_LOG(LogAsym, Error, TEXT("SetTagsOnTile cannot be called on client"));
+		return;
+	}
+	
+	const FTileStateBits NewStateBits = AsymTileState::FromTags(NewTags);
+	if (FMath::CountBits(NewStateBits) != NewTags.Num())
+	{
+		UE_LOG(LogAsym, Warning, TEXT("SetTagsOnTile dropped tags that are not registered as tile state: %s"), *NewTags.ToString());
+	}
+
+	if (SetStateOnTiles(MakeArrayView(&TileIndex, 1), NewStateBits) > 0)
+	{
+		UE_LOG(LogAsym, Warning, TEXT("Tile with index %d not found"), TileIndex);
+	}
+}
+
+int32 AHexGrid::SetStateOnTiles(const TConstArrayView<int32> TileIndices, const FTileStateBits StateBits, AActor* Instigator)
+{
+	if(!HasAuthority())
+	{
+		UE_LOG(LogAsym, Error, TEXT("SetStateOnTiles cannot be called on client"));
+		return 0;
+	}
+
+	const FTileStateBits NewStateBits = StateBits & AsymTileState::AllBits;
+
+	// Removals only need one MarkArrayDirty per chunk, item updates are marked individually
+	TBitArray<> ChunksWithRemovals(false, Chunks.Num());
+
+	int32 NumInvalidTiles = 0;
+	for (const int32 TileIndex : TileIndices)
+	{
+		NumInvalidTiles += !SetTileState(TileIndex, NewStateBits, Instigator, ChunksWithRemovals);
+	}
+
+	for (TConstSetBitIterator<> It(ChunksWithRemovals); It; ++It)
+	{
+		Chunks[It.GetIndex()]->TileArray.MarkArrayDirty();
+	}
+
+	return NumInvalidTiles;
+}
+
+bool AHexGrid::SetTileState(const int32 TileIndex, const FTileStateBits StateBits, AActor* Instigator, TBitArray<>& ChunksWithRemovals)
+{
+	if (!TileStore.IsValidIndex(TileIndex))
+	{
+		return false;
+	}
+
+	const FTileStateBits OldStateBits = TileStore.GetState(TileIndex);
+	if (OldStateBits == StateBits)
+	{
+		return true;
+	}
+
+	FTileData Tile = GetTileFromIndex(TileIndex);
+	Tile.StateBits = StateBits;
+
+	ApplyTile(Tile);
+	if (ReplicateTile(Tile))
+	{
+		ChunksWithRemovals[GetLayout().GetChunkIndex(TileIndex)] = true;
+	}
+
+	Journal.Record(TileIndex, OldStateBits, StateBits, Instigator);
+	return true;
+}
+
+bool AHexGrid::GetTileChanges(const int64 FromSequence, TArray<FHexTileChange>& OutChanges) const
+{
+	OutChanges.Reset();
+
+	if (FromSequence < Journal.GetFirstSequence() || FromSequence > Journal.GetNextSequence())
+	{
+		return false;
+	}
+
+	OutChanges.Reserve(Journal.GetNextSequence() - FromSequence);
+	for (int64 Sequence = FromSequence; Sequence < Journal.GetNextSequence(); ++Sequence)
+	{
+		OutChanges.Add(Journal.Get(Sequence));
+	}
+
+	return true;
+}
+
+bool AHexGrid::UndoTileChanges(const int64 FirstSequence, const int64 EndSequence, AActor* Instigator)
+{
+	if (!HasAuthority() || FirstSequence > EndSequence || EndSequence > Journal.GetNextSequence())
+	{
+		return false;
+	}
+
+	// An empty range has nothing to revert, even at the end of the journal where FirstSequence was not written yet
+	if (FirstSequence == EndSequence)
+	{
+		return true;
+	}
+
+	if (!Journal.Contains(FirstSequence))
+	{
+		return false;
+	}
+
+	// Collected first, the reverts are journaled and would overwrite the oldest changes while still reading them
+	UndoScratch.Reset();
+	for (int64 Sequence = EndSequence - 1; Sequence >= FirstSequence; --Sequence)
+	{
+		const FHexTileChange& Change = Journal.Get(Sequence);
+		UndoScratch.Emplace(Change.TileIndex, Change.OldStateBits);
+	}
+
+	TBitArray<> ChunksWithRemovals(false, Chunks.Num());
+
+	for (const TPair<int32, FTileStateBits>& TileState : UndoScratch)
+	{
+		SetTileState(TileState.Key, TileState.Value, Instigator, ChunksWithRemovals);
+	}
+
+	for (TConstSetBitIterator<> It(ChunksWithRemovals); It; ++It)
+	{
+		Chunks[It.GetIndex()]->TileArray.MarkArrayDirty();
+	}
+
+	return true;
+}
+
+int32 AHexGrid::GetTileIndexFromInstance(const UPrimitiveComponent* Component, const int32 InstanceIndex) const
+{
+	const UHexInstancedStaticMeshComponent* ChunkMesh = Cast<UHexInstancedStaticMeshComponent>(Component);
+	if (!ChunkMesh || GetChunkMesh(ChunkMesh->ChunkIndex) != ChunkMesh)
+	{
+		return INDEX_NONE;
+	}
+
+	const FHexGridLayout Layout = GetLayout();
+	if (InstanceIndex < 0 || InstanceIndex >= Layout.GetChunkNumTiles(ChunkMesh->ChunkIndex))
+	{
+		return INDEX_NONE;
+	}
+
+	return Layout.GetTileIndexFromChunkInstance(ChunkMesh->ChunkIndex, InstanceIndex);
+}
+
+
+
+bool AHexGrid::RaycastTile(const FVector& Start, const FVector& End, int32& OutTileIndex, FVector& OutHitLocation) const
+{
+	OutTileIndex = INDEX_NONE;
+
+	const FHexGridLayout Layout = GetLayout();
+	if (Layout.Num() == 0 || TileStore.Num() != Layout.Num())
+	{
+		return false;
+	}
+
+	// Everything below runs in grid space, T goes from 0 at Start to 1 at End
+	const FTransform& GridTransform = GetActorTransform();
+	const FVector Origin = GridTransform.InverseTransformPosition(Start);
+	const FVector Delta = GridTransform.InverseTransformPosition(End) - Origin;
+
+	// Clip the segment to the board
+	const FBox2D Bounds = Layout.GetLocalBounds();
+	double TMin = 0.0;
+	double TMax = 1.0;
+	for (int32 Axis = 0; Axis < 2; ++Axis)
+	{
+		if (FMath::IsNearlyZero(Delta[Axis]))
+		{
+			if (Origin[Axis] < Bounds.Min[Axis] || Origin[Axis] > Bounds.Max[Axis])
+			{
+				return false;
+			}
+			continue;
+		}
+
+		double TNear = (Bounds.Min[Axis] - Origin[Axis]) / Delta[Axis];
+		double TFar = (Bounds.Max[Axis] - Origin[Axis]) / Delta[Axis];
+		if (TNear > TFar)
+		{
+			Swap(TNear, TFar);
+		}
+
+		TMin = FMath::Max(TMin, TNear);
+		TMax = FMath::Min(TMax, TFar);
+		if (TMin > TMax)
+		{
+			return false;
+		}
+	}
+
+	// Edges of a cell lie half the center distance away, facing the neighbor in that direction
+	const double Apothem = Radius * UE_DOUBLE_SQRT_3 * 0.5;
+	FVector2D EdgeNormals[6];
+	for (int32 Direction = 0; Direction < 6; ++Direction)
+	{
+		EdgeNormals[Direction] = FVector2D(Layout.ToLocal(FHexCoord::Direction(Direction))).GetSafeNormal();
+	}
+
+	const FVector2D Origin2D(Origin);
+	const FVector2D Delta2D(Delta);
+
+	// Walk the cells the segment crosses in order, a straight line crosses at most every row and column once plus the diagonal steps
+	FHexCoord Cell = Layout.FromLocal(Origin + Delta * TMin);
+	double TEnter = TMin;
+	const int32 MaxSteps = 2 * (Layout.Rows + Layout.Columns) + 2;
+
+	for (int32 Step = 0; Step < MaxSteps && TEnter <= TMax; ++Step)
+	{
+		const FVector2D CellOffset = Origin2D - FVector2D(Layout.ToLocal(Cell));
+
+		double TExit = TMax;
+		int32 ExitDirection = INDEX_NONE;
+		for (int32 Direction = 0; Direction < 6; ++Direction)
+		{
+			const double Speed = FVector2D::DotProduct(Delta2D, EdgeNormals[Direction]);
+			if (Speed <= UE_SMALL_NUMBER)
+			{
+				continue;
+			}
+
+			const double T = (Apothem - FVector2D::DotProduct(CellOffset, EdgeNormals[Direction])) / Speed;
+			if (T < TExit)
+			{
+				TExit = T;
+				ExitDirection = Direction;
+			}
+		}
+		TExit = FMath::Max(TExit, TEnter);
+
+		const int32 TileIndex = Layout.ToTileIndex(Cell);
+		if (TileIndex != INDEX_NONE)
+		{
+			const double TopZ = TileStore.GetHeight(TileIndex) + TileTopOffset;
+			const double EnterZ = Origin.Z + Delta.Z * TEnter;
+			const double ExitZ = Origin.Z + Delta.Z * TExit;
+
+			// Entering below the top hits the side of the prism, otherwise the segment may still go through the top face
+			if (EnterZ <= TopZ || ExitZ <= TopZ)
+			{
+				const double THit = EnterZ <= TopZ ? TEnter : (TopZ - Origin.Z) / Delta.Z;
+				OutTileIndex = TileIndex;
+				OutHitLocation = GridTransform.TransformPosition(Origin + Delta * THit);
+				return true;
+			}
+		}
+
+		if (ExitDirection == INDEX_NONE)
+		{
+			break;
+		}
+
+		Cell = Cell.Neighbor(ExitDirection);
+		TEnter = TExit;
+	}
+
+	return false;
+}
+
+FTileData AHexGrid::GetTileFromIndex(const int32 Index) const
+{
+	if (!TileStore.IsValidIndex(Index))
+	{
+		UE_LOG(LogAsym, Warning, TEXT("Tile with index %d not found"), Index);
+		return FTileData();
+	}
+
+	FTileData Tile;
+	Tile.TileIndex = Index;
+	Tile.Height = TileStore.GetHeight(Index);
+	Tile.StateBits = TileStore.GetState(Index);
+	return Tile;
+}
+
+bool AHexGrid::ReplicateTile(const FTileData& Tile)
+{
+	UHexGridChunk* Chunk = Chunks[GetLayout().GetChunkIndex(Tile.TileIndex)];
+	FTileDataArray& TileArray = Chunk->TileArray;
+
+	FTileData* ReplicatedTile = TileArray.FindTile(Tile.TileIndex);
+
+	// Tiles that went back to their default no longer need to be sent
+	if (bReplicateSparseTiles && IsDefaultTile(Tile))
+	{
+		return ReplicatedTile && TileArray.RemoveTile(Tile.TileIndex);
+	}
+
+	if (!ReplicatedTile)
+	{
+		ReplicatedTile = &TileArray.AddTile(Tile);
+	}
+
+	ReplicatedTile->Height = Tile.Height;
+	ReplicatedTile->StateBits = Tile.StateBits;
+	TileArray.MarkItemDirty(*ReplicatedTile);
+	return false;
+}
+
+bool AHexGrid::IsDefaultTile(const FTileData& Tile) const
+{
+	const FTileData DefaultTile = MakeDefaultTile(Tile.TileIndex);
+	return DefaultTile.StateBits == Tile.StateBits
+		&& FTileData::QuantizeHeight(DefaultTile.Height) == FTileData::QuantizeHeight(Tile.Height);
+}
+
+
+
+#pragma region FTileData
+
+static AHexGrid* GetOwningGrid(const FTileDataArray& TileArray)
+{
+	const UHexGridChunk* Chunk = Cast<UHexGridChunk>(TileArray.OwningObject);
+	return Chunk ? Chunk->GetGrid() : nullptr;
+}
+
+void FTileData::PostReplicatedAdd(const FTileDataArray& InArraySerializer)
+{
+	InArraySerializer.MarkLookupDirty();
+	++FHexGridNetStats::Get().NumAdds;
+
+	AHexGrid* HexGrid = GetOwningGrid(InArraySerializer);
+	if (HexGrid && HexGrid->ISMC)
+	{
+		FHexGridNetStats::FScopedApply ScopedApply;
+
+		// Instance updates are flushed once for the whole batch in FTileDataArray::PostReplicatedReceive
+		HexGrid->ApplyTile(*this);
+
+		UE_LOG(LogAsym, Verbose, TEXT("PostReplicatedAdd %d"), TileIndex);
+	}
+}
+
+void FTileData::PreReplicatedRemove(const struct FTileDataArray& InArraySerializer)
+{
+	// Removal swaps the last item into this slot
+	InArraySerializer.MarkLookupDirty();
+	++FHexGridNetStats::Get().NumRemoves;
+
+	// The server only removes tiles that went back to their default
+	AHexGrid* HexGrid = GetOwningGrid(InArraySerializer);
+	if (HexGrid && HexGrid->ISMC)
+	{
+		FHexGridNetStats::FScopedApply ScopedApply;
+		HexGrid->ApplyTile(HexGrid->MakeDefaultTile(TileIndex));
+	}
+}
+
+void FTileData::PostReplicatedChange(const struct FTileDataArray& InArraySerializer)
+{
+	++FHexGridNetStats::Get().NumChanges;
+
+	AHexGrid* HexGrid = GetOwningGrid(InArraySerializer);
+	if (HexGrid && HexGrid->ISMC)
+	{
+		FHexGridNetStats::FScopedApply ScopedApply;
+		HexGrid->ApplyTile(*this);
+	}
 }
 
 #pragma endregion // FTileData
+
+#pragma region FTileDataArray
+
+void FTileDataArray::PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters)
+{
+	// Rebuild once per received batch instead of on the first lookup that misses
+	if (bLookupDirty)
+	{
+		RebuildLookup();
+	}
+
+	++FHexGridNetStats::Get().NumReceives;
+
+	const UHexGridChunk* Chunk = Cast<UHexGridChunk>(OwningObject);
+	const AHexGrid* HexGrid = Chunk ? Chunk->GetGrid() : nullptr;
+	if (UHexInstancedStaticMeshComponent* ChunkMesh = HexGrid ? HexGrid->GetChunkMesh(Chunk->GetChunkIndex()) : nullptr)
+	{
+		FHexGridNetStats::FScopedApply ScopedApply;
+		ChunkMesh->FlushPendingUpdates();
+	}
+}
+
+FTileData* FTileDataArray::FindTile(const int32 TileIndex)
+{
+	return const_cast<FTileData*>(static_cast<const FTileDataArray*>(this)->FindTile(TileIndex));
+}
+
+const FTileData* FTileDataArray::FindTile(const int32 TileIndex) const
+{
+	const int32* Slot = TileLookup.Find(TileIndex);
+	if (Slot && Items.IsValidIndex(*Slot) && Items[*Slot] == TileIndex)
+	{
+		return &Items[*Slot];
+	}
+
+	if (!bLookupDirty && !Slot)
+	{
+		return nullptr;
+	}
+
+	// Either the lookup was flagged stale or the slot no longer holds this tile
+	RebuildLookup();
+
+	Slot = TileLookup.Find(TileIndex);
+	return Slot ? &Items[*Slot] : nullptr;
+}
+
+FTileData& FTileDataArray::AddTile(const FTileData& NewTile)
+{
+	const int32 Slot = Items.Add(NewTile);
+	TileLookup.Add(NewTile.TileIndex, Slot);
+	return Items[Slot];
+}
+
+bool FTileDataArray::RemoveTile(const int32 TileIndex)
+{
+	const FTileData* Tile = FindTile(TileIndex);
+	if (!Tile)
+	{
+		return false;
+	}
+
+	const int32 Slot = UE_PTRDIFF_TO_INT32(Tile - Items.GetData());
+	Items.RemoveAtSwap(Slot);
+
+	TileLookup.Remove(TileIndex);
+	if (Items.IsValidIndex(Slot))
+	{
+		TileLookup.Add(Items[Slot].TileIndex, Slot);
+	}
+
+	return true;
+}
+
+void FTileDataArray::Reset()
+{
+	Items.Empty();
+	TileLookup.Empty();
+	bLookupDirty = false;
+	MarkArrayDirty();
+}
+
+void FTileDataArray::RebuildLookup() const
+{
+	TileLookup.Reset();
+	TileLookup.Reserve(Items.Num());
+
+	for (int32 Slot = 0; Slot < Items.Num(); ++Slot)
+	{
+		TileLookup.Add(Items[Slot].TileIndex, Slot);
+	}
+
+	bLookupDirty = false;
+}
+
+#pragma endregion // FTileDataArray
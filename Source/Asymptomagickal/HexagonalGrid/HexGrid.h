@@ -5,8 +5,79 @@
 #include "CoreMinimal.h"
 #include "Asymptomagickal/Interface/TileInterface.h"
 #include "GameFramework/Actor.h"
+#include "HexCoord.h"
+#include "HexFlowField.h"
+#include "HexPathfinder.h"
+#include "HexTileJournal.h"
+#include "HexTileStore.h"
+#include "HexVisibility.h"
 #include "HexGrid.generated.h"
 
+class UHexGridChunk;
+class UHexInstancedStaticMeshComponent;
+class UHexTileGenerator;
+
+/**
+ * Everything a client needs to rebuild the procedural grid on its own
+ */
+USTRUCT()
+struct FHexGridParams
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	int32 Rows = 0;
+	UPROPERTY()
+	int32 Columns = 0;
+	UPROPERTY()
+	float Radius = 0.f;
+	UPROPERTY()
+	float RandomSpan = 0.f;
+	UPROPERTY()
+	int32 Seed = 0;
+	UPROPERTY()
+	int32 ChunkSize = 0;
+	/** Board snapshot the grid starts from instead of generating, empty if generated */
+	UPROPERTY()
+	FString BoardSnapshotFile;
+	/** Payload checksum of the server's snapshot, clients refuse to play on a different board */
+	UPROPERTY()
+	uint32 BoardSnapshotChecksum = 0;
+};
+
+/**
+ * Immutable copy of the grid for queries on worker threads. Shares unchanged tile blocks with the live grid.
+ */
+struct FHexGridSnapshot
+{
+	FHexGridLayout Layout;
+	FHexTileStore Tiles;
+	/** Tile store version the snapshot was taken at */
+	uint32 Version = 0;
+};
+
+using FHexGridSnapshotRef = TSharedRef<const FHexGridSnapshot, ESPMode::ThreadSafe>;
+
+/**
+ * Result of an async grid query
+ */
+USTRUCT(BlueprintType)
+struct FHexGridQueryResult
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly, Category="HexGrid")
+	bool bSuccess = false;
+
+	/** Path from start to goal, or the tiles of an area query */
+	UPROPERTY(BlueprintReadOnly, Category="HexGrid")
+	TArray<int32> TileIndices;
+
+	/** Tile store version of the snapshot the query ran on, tiles may have changed since */
+	UPROPERTY(BlueprintReadOnly, Category="HexGrid")
+	int32 SnapshotVersion = 0;
+};
+
 /**
  * Server Authoritative Actor Class that has an IMC to create a Hexagonal Grid
  */
@@ -15,21 +86,157 @@ class ASYMPTOMAGICKAL_API AHexGrid : public AActor, public ITileInterface
 {
 	GENERATED_BODY()
 
+	friend class FHexGridSoak;
+	friend class FHexGridTestAccess;
+
 public:
 	AHexGrid();
 
 	UPROPERTY(BlueprintReadOnly)
-	TObjectPtr<UInstancedStaticMeshComponent> ISMC;
+	TObjectPtr<UHexInstancedStaticMeshComponent> ISMC;
 	
 	/** ITileInterface **/
 	UFUNCTION()
 	virtual FTileData GetTileDataFromItem(const int32 Item) override;
 	UFUNCTION()
 	virtual void SetTagsOnTile(const int32 TileIndex, const FGameplayTagContainer& NewTags) override;
+	virtual int32 SetStateOnTiles(const TConstArrayView<int32> TileIndices, const FTileStateBits StateBits, AActor* Instigator = nullptr) override;
+	virtual int32 GetTileIndexFromInstance(const UPrimitiveComponent* Component, const int32 InstanceIndex) const override;
+
+	/**
+	 * Intersects the world space segment with the tile prisms (hex cell from below up to the top of the tile) using grid math
+	 * and the local tile heights, cheap enough for per frame hover picking and independent of instance collision
+	 */
+	UFUNCTION(BlueprintCallable, Category="HexGrid")
+	virtual bool RaycastTile(const FVector& Start, const FVector& End, int32& OutTileIndex, FVector& OutHitLocation) const override;
+
+	/** Queues the instance transform and custom data for the tile, the ISMC flushes it in one batch */
+	void UpdateTileInstance(const FTileData& Tile) const;
+
+	/** Writes the tile into the local tile store and queues its instance update, ignored until the grid is built */
+	void ApplyTile(const FTileData& Tile);
+
+	/** The tile as the board starts out, from the board snapshot or the seeded generation, identical on server and clients */
+	FTileData MakeDefaultTile(const int32 TileIndex) const;
+
+	/** The tile as the seeded procedural generation creates it, ignores the board snapshot */
+	FTileData GenerateTile(const int32 TileIndex) const;
+
+	/** Runs the generation for every tile, chunks are generated in parallel. Outputs are indexed by tile index */
+	void GenerateTiles(const FHexGridLayout& Layout, TArray<float>& OutHeights, TArray<FTileStateBits>& OutStates) const;
+
+	/** Dimensions of the grid, use it together with the FHexCoord ranges for neighbor, ring and area queries */
+	FHexGridLayout GetLayout() const { return FHexGridLayout(Rows, Columns, Radius, ChunkSize); }
+
+	/** Instanced mesh rendering the tiles of the chunk, nullptr before the grid was built */
+	UHexInstancedStaticMeshComponent* GetChunkMesh(const int32 ChunkIndex) const;
+
+	/**
+	 * Client only, called when a chunk object arrives. Chunks that left relevancy keep their last known tiles,
+	 * so the chunk's tiles are reset to the default and patched with what it carries now.
+	 */
+	void RestoreChunk(const UHexGridChunk& Chunk);
+
+	UFUNCTION(BlueprintPure, Category="HexGrid")
+	FHexCoord GetTileCoord(const int32 TileIndex) const;
+
+	/** Returns -1 if the coordinate is outside of the grid */
+	UFUNCTION(BlueprintPure, Category="HexGrid")
+	int32 GetTileIndexFromCoord(const FHexCoord& Coord) const;
+
+	/** Tile indices within Range steps of the center tile, ordered from the center outwards */
+	UFUNCTION(BlueprintCallable, Category="HexGrid")
+	void GetTilesInRange(const int32 CenterTileIndex, const int32 Range, TArray<int32>& OutTileIndices) const;
+
+	/**
+	 * Shortest path honoring tile permissions and the height limits of the query, OutPath holds the tile indices from start
+	 * to goal. Runs on the local tile store, so clients get the same answer for the tiles they know about.
+	 */
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Pathfinding")
+	bool FindPath(const int32 StartTileIndex, const int32 GoalTileIndex, const FHexPathQuery& Query, TArray<int32>& OutPath);
+
+	UFUNCTION(BlueprintPure, Category="HexGrid|Pathfinding")
+	bool CanAgentEnterTile(const int32 TileIndex, const EHexPathAgent Agent) const;
+
+	/**
+	 * Starts maintaining a flow field towards the goal tile, for goals many agents walk to (King, objectives).
+	 * Returns the id used for lookups, the field is repaired locally whenever tiles change.
+	 */
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Pathfinding")
+	int32 RegisterFlowFieldGoal(const int32 GoalTileIndex, const FHexPathQuery& Query);
+
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Pathfinding")
+	void UnregisterFlowFieldGoal(const int32 FlowFieldId);
+
+	/** Neighbor to step on towards the flow field's goal, INDEX_NONE at the goal or if it cannot be reached */
+	UFUNCTION(BlueprintPure, Category="HexGrid|Pathfinding")
+	int32 GetFlowFieldNextTile(const int32 FlowFieldId, const int32 TileIndex);
+
+	/** Path cost to the flow field's goal, negative if it cannot be reached */
+	UFUNCTION(BlueprintPure, Category="HexGrid|Pathfinding")
+	float GetFlowFieldDistance(const int32 FlowFieldId, const int32 TileIndex);
+
+	/** Full local tile state, for C++ queries that run their own searches */
+	const FHexTileStore& GetTileStore() const { return TileStore; }
+
+	/**
+	 * Tiles visible from EyeHeight above the observer tile within Range steps, ordered from the observer outwards.
+	 * Results are cached per observer tile and dropped as soon as any tile height changes.
+	 */
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Visibility")
+	void GetVisibleTiles(const int32 ObserverTileIndex, const int32 Range, const float EyeHeight, TArray<int32>& OutTileIndices);
+
+	/** True if no tile between both rises above the sight line from EyeHeight above the first tile to the top of the second */
+	UFUNCTION(BlueprintPure, Category="HexGrid|Visibility")
+	bool HasLineOfSight(const int32 FromTileIndex, const int32 ToTileIndex, const float EyeHeight) const;
+
+	/** Snapshot of the current tiles, only taken again after the tiles changed */
+	FHexGridSnapshotRef GetSnapshot() const;
+
+	/*
+	 *	Async queries, run on the task graph against the current snapshot. The futures complete on a worker thread.
+	 */
+	TFuture<FHexGridQueryResult> FindPathAsync(const int32 StartTileIndex, const int32 GoalTileIndex, const FHexPathQuery& Query) const;
+
+	/** Tiles the agent can reach from the start within MaxCost */
+	TFuture<FHexGridQueryResult> FindReachableTilesAsync(const int32 StartTileIndex, const float MaxCost, const FHexPathQuery& Query) const;
+
+	/** Tiles within Range steps of the center the agent may enter, ordered from the center outwards */
+	TFuture<FHexGridQueryResult> FindTilesInRangeAsync(const int32 CenterTileIndex, const int32 Range, const FHexPathQuery& Query) const;
+
+	/** Server only, writes the current tiles as a board snapshot. Relative paths are relative to the project directory */
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Snapshot")
+	bool SaveBoardSnapshot(const FString& FilePath) const;
 
+	/**
+	 * Server only, rebuilds the grid from the board snapshot and drops every tile change made so far.
+	 * Clients load the same file, so it has to exist on every machine.
+	 */
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Snapshot")
+	bool LoadBoardSnapshot(const FString& FilePath);
+
+	/** Server only, every tile state change since the grid was built, as far back as JournalCapacity reaches */
+	const FHexTileJournal& GetJournal() const { return Journal; }
+
+	/** Server only, sequence the next tile change will be journaled with */
+	UFUNCTION(BlueprintPure, Category="HexGrid|Journal")
+	int64 GetJournalSequence() const { return Journal.GetNextSequence(); }
+
+	/** Server only, the journaled changes from FromSequence on, false if some of them already left the journal */
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Journal")
+	bool GetTileChanges(const int64 FromSequence, TArray<FHexTileChange>& OutChanges) const;
+
+	/**
+	 * Server only, reverts the journaled changes from FirstSequence up to (excluding) EndSequence, newest first.
+	 * The revert is journaled like any other change. Tiles changed again after EndSequence are reverted too.
+	 * False if the range is not in the journal (anymore), an empty range always succeeds.
+	 */
+	UFUNCTION(BlueprintCallable, Category="HexGrid|Journal")
+	bool UndoTileChanges(const int64 FirstSequence, const int64 EndSequence, AActor* Instigator = nullptr);
 	
 protected:
 	virtual void BeginPlay() override;
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
 	//Editor functions for grid manipulation
 	UFUNCTION(CallInEditor, Category="HexGrid")
@@ -45,17 +252,188 @@ protected:
 	UPROPERTY(EditAnywhere, Category="HexGrid")
 	TObjectPtr<UStaticMesh> HexMesh;
 
-	//Fast TArray for replication
-	UPROPERTY(Replicated)
-	FTileDataArray TileArray;
+	/**
+	 * Per instance collision of the chunk meshes. Building and querying it is expensive on big boards,
+	 * without it tiles are picked with RaycastTile
+	 */
+	UPROPERTY(EditAnywhere, Category="HexGrid")
+	bool bEnableInstanceCollision = true;
+
+	/**
+	 * Keeps the instance transforms where the grid was built and sends height changes to the material only, as the height
+	 * offset in the instance custom data (see UHexInstancedStaticMeshComponent). Avoids the transform, bounds and collision
+	 * updates of animated boards, but the material has to apply the offset, the mesh bounds extension has to cover it and
+	 * instance collision stays at the built height (RaycastTile still uses the current heights).
+	 */
+	UPROPERTY(EditAnywhere, Category="HexGrid|Rendering")
+	bool bStaticInstanceTransforms = false;
+
+	/**
+	 * Applied in order on top of the seeded random height (RandomSpan) of every tile. Clients run them too,
+	 * so they have to be configured identically on every machine (placed in the level or set in the class defaults).
+	 */
+	UPROPERTY(EditAnywhere, Instanced, Category="HexGrid|Generation")
+	TArray<TObjectPtr<UHexTileGenerator>> Generators;
+
+	/**
+	 * Board snapshot (see SaveBoardSnapshot) the grid starts from instead of running the generation, its rows, columns and
+	 * radius override the grid settings. The server falls back to the generation if the file cannot be loaded, clients that
+	 * cannot load the server's snapshot or load a different one leave the game.
+	 */
+	UPROPERTY(EditAnywhere, Category="HexGrid|Generation")
+	FString BoardSnapshotFile;
+
+	/** Tile changes the server keeps for undo and replay, older ones are folded into the journal's base board. 0 disables the journal */
+	UPROPERTY(EditAnywhere, Category="HexGrid|Journal", meta=(ClampMin="0"))
+	int32 JournalCapacity = 4096;
+
+	/**
+	 * If true only tiles that differ from the procedural default are replicated and clients generate the rest themselves,
+	 * so join bandwidth scales with the number of modified tiles. If false every tile is replicated.
+	 */
+	UPROPERTY(EditAnywhere, Category="HexGrid|Replication")
+	bool bReplicateSparseTiles = true;
+
+	/**
+	 * Chunks further than this from a player's view point (in grid space) are not replicated to that player, who keeps
+	 * seeing the last state received until the chunk is in range again. 0 replicates every chunk to everyone.
+	 */
+	UPROPERTY(EditAnywhere, Category="HexGrid|Replication", meta=(ClampMin="0", Units="cm"))
+	float ChunkRelevancyDistance = 10000.f;
+
+	/** Seconds between chunk relevancy updates on the server */
+	UPROPERTY(EditAnywhere, Category="HexGrid|Replication", meta=(ClampMin="0.05", EditCondition="ChunkRelevancyDistance > 0"))
+	float ChunkRelevancyUpdateInterval = 0.5f;
+
+	/** Replicated subobjects, each holds the Fast TArray for the tiles of one chunk, indexed by chunk index */
+	UPROPERTY(ReplicatedUsing=OnRep_Chunks)
+	TArray<TObjectPtr<UHexGridChunk>> Chunks;
+
+	UPROPERTY(ReplicatedUsing=OnRep_GridParams)
+	FHexGridParams GridParams;
+
+	UFUNCTION()
+	void OnRep_Chunks();
+
+	UFUNCTION()
+	void OnRep_GridParams();
 
 private:
+	/** Sets up the tiles and builds the chunk meshes from them */
 	void InitInstancesLocally();
+
+	/** Fills the tile store from the board snapshot if one is set, otherwise from the generation */
+	void InitTiles();
+
+	/** Takes the tiles and dimensions of a loaded board snapshot */
+	void UseBoardSnapshot(const FHexGridLayout& SnapshotLayout, const FHexTileStore& SnapshotTiles, const uint32 Checksum);
+
+	/** Builds the chunk meshes from the tile store, clients apply the replicated chunks on top */
+	void BuildInstances();
+
+	/**
+	 * Clients only, once the tiles are set up for the server's params. Disconnects if the server plays on a board snapshot
+	 * and this machine could not load it or loaded a different one, the boards would not match.
+	 */
+	void CheckBoardSnapshot();
+
+	/** Spawns one instanced mesh per chunk, they copy mesh, materials and collision from the root ISMC */
+	void CreateChunkMeshes(const FHexGridLayout& Layout);
+
+	/** Applies the tiles that replicated in the chunks before the grid was built */
+	void ApplyReplicatedChunks();
 	
 	void InitializeHexGrid();
+
+	/** Server only, unregisters the chunks from their net condition groups and takes every player out of them */
+	void RemoveChunkNetGroups();
+
+	/** Server only, adds or removes every remote player to the net condition group of each chunk based on distance */
+	void UpdateChunkRelevancy();
 	
 	FTileData GetTileFromIndex(int32 Index) const;
 
+	/** Adds, updates or drops the tile in its chunk's TileArray, returns true if it was dropped and the array still needs MarkArrayDirty */
+	bool ReplicateTile(const FTileData& Tile);
+
+	/**
+	 * Server side state change of one tile, flags the tile's chunk if the chunk's TileArray still needs MarkArrayDirty.
+	 * Returns false if the tile is not on the grid.
+	 */
+	bool SetTileState(const int32 TileIndex, const FTileStateBits StateBits, AActor* Instigator, TBitArray<>& ChunksWithRemovals);
+
+	bool IsDefaultTile(const FTileData& Tile) const;
+
+	/** Full tile state on this machine, defaults from generation patched with the replicated chunks */
+	FHexTileStore TileStore;
+
+	/** The board before any tile changed, what MakeDefaultTile returns. Shares its blocks with TileStore until tiles change */
+	FHexTileStore BaseTiles;
+
+	/** The tiles came from BoardSnapshotFile instead of the generation */
+	bool bLoadedSnapshot = false;
+
+	/** Payload checksum of the loaded board snapshot, only valid if bLoadedSnapshot */
+	uint32 BoardSnapshotChecksum = 0;
+
+	/** Server only */
+	FHexTileJournal Journal;
+
+	/** Tiles and states UndoTileChanges applies, reserved for the whole journal */
+	TArray<TPair<int32, FTileStateBits>> UndoScratch;
+
+	/** Pooled search state shared by all game thread path queries */
+	FHexPathfinder Pathfinder;
+
+	mutable TSharedPtr<const FHexGridSnapshot, ESPMode::ThreadSafe> CachedSnapshot;
+
+	struct FFieldOfViewKey
+	{
+		int32 ObserverTileIndex;
+		int32 Range;
+		int32 QuantizedEyeHeight;
+
+		bool operator==(const FFieldOfViewKey& Other) const
+		{
+			return ObserverTileIndex == Other.ObserverTileIndex && Range == Other.Range && QuantizedEyeHeight == Other.QuantizedEyeHeight;
+		}
+
+		friend uint32 GetTypeHash(const FFieldOfViewKey& Key)
+		{
+			return HashCombine(HashCombine(GetTypeHash(Key.ObserverTileIndex), GetTypeHash(Key.Range)), GetTypeHash(Key.QuantizedEyeHeight));
+		}
+	};
+
+	FHexVisibility Visibility;
+	TMap<FFieldOfViewKey, TArray<int32>> FieldOfViewCache;
+
+	/** Changes whenever a tile height changes, the field of view cache is only valid for the version it was filled at */
+	uint32 HeightVersion = 0;
+	uint32 FieldOfViewCacheVersion = 0;
+
+	/** Repairs all flow fields with the tiles changed since the last update */
+	void UpdateFlowFields();
+
+	TMap<int32, FHexFlowField> FlowFields;
+	int32 NextFlowFieldId = 0;
+
+	/** Tiles whose state or height changed since the flow fields were last repaired, may contain duplicates */
+	TArray<int32> FlowFieldDirtyTiles;
+	bool bFlowFieldUpdateScheduled = false;
+
+	/** Locally spawned, never replicated, indexed by chunk index */
+	UPROPERTY(Transient)
+	TArray<TObjectPtr<UHexInstancedStaticMeshComponent>> ChunkMeshes;
+
+	/** Server only, net condition group and grid space XY bounds per chunk, used when ChunkRelevancyDistance is set */
+	TArray<FName> ChunkNetGroups;
+	TArray<FBox2D> ChunkBounds;
+
+	FTimerHandle ChunkRelevancyTimerHandle;
+
+	/** Top of the hex mesh above the instance origin, the height RaycastTile tests against on top of the tile height */
+	float TileTopOffset = 0.f;
+
 private:
 	UPROPERTY(EditAnywhere, Category="HexGrid", meta=(AllowPrivateAccess="true"))
 	float Radius = 50.f;
@@ -65,4 +443,9 @@ private:
 	int32 Columns = 4;
 	UPROPERTY(EditAnywhere, Category="HexGrid", meta=(AllowPrivateAccess="true"))
 	float RandomSpan = 10.f;
+	UPROPERTY(EditAnywhere, Category="HexGrid", meta=(AllowPrivateAccess="true"))
+	int32 Seed = 0;
+	/** Tiles per chunk side. Every chunk is replicated and rendered on its own, 0 keeps the whole grid in one chunk */
+	UPROPERTY(EditAnywhere, Category="HexGrid", meta=(AllowPrivateAccess="true", ClampMin="0"))
+	int32 ChunkSize = 16;
 };
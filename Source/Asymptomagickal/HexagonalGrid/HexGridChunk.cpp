@@ -0,0 +1,57 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexGridChunk.h"
+
+#include "HexGrid.h"
+#include "Net/UnrealNetwork.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/Core/PushModel/PushModel.h"
+
+static TAutoConsoleVariable<bool> CVarHexGridPushModel(
+	TEXT("Asym.HexGrid.PushModel"),
+	true,
+	TEXT("Replicates the chunk tile arrays push based. Read when the replication layout is built, set it in the ini or on the command line.\n")
+	TEXT("The Asym.HexGrid.Benchmark automation test measures both modes, compare the net soak numbers of runs with either setting"),
+	ECVF_ReadOnly);
+
+UHexGridChunk::UHexGridChunk()
+{
+	TileArray.OwningObject = this;
+}
+
+void UHexGridChunk::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// Push based unless switched off for comparisons, see Asym.HexGrid.PushModel
+	FDoRepLifetimeParams ChunkParams;
+	ChunkParams.bIsPushBased = CVarHexGridPushModel.GetValueOnAnyThread();
+	DOREPLIFETIME_WITH_PARAMS_FAST(UHexGridChunk, TileArray, ChunkParams);
+
+	FDoRepLifetimeParams IndexParams;
+	IndexParams.bIsPushBased = true;
+	IndexParams.Condition = COND_InitialOnly;
+	DOREPLIFETIME_WITH_PARAMS_FAST(UHexGridChunk, ChunkIndex, IndexParams);
+}
+
+AHexGrid* UHexGridChunk::GetGrid() const
+{
+	return GetTypedOuter<AHexGrid>();
+}
+
+void UHexGridChunk::OnRep_ChunkIndex()
+{
+	if (AHexGrid* HexGrid = GetGrid())
+	{
+		HexGrid->RestoreChunk(*this);
+	}
+}
+
+void UHexGridChunk::InitChunk(const int32 InChunkIndex)
+{
+	ChunkIndex = InChunkIndex;
+	MARK_PROPERTY_DIRTY_FROM_NAME(UHexGridChunk, ChunkIndex, this);
+
+	TileArray.Reset();
+}
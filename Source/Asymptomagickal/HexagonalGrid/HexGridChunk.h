@@ -0,0 +1,43 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Asymptomagickal/Interface/TileInterface.h"
+#include "UObject/Object.h"
+#include "HexGridChunk.generated.h"
+
+class AHexGrid;
+
+/**
+ * Replicated slice of a hex grid. Owns the fast array for the tiles of one chunk, so a tile change only dirties
+ * and serializes its own chunk instead of the whole grid.
+ */
+UCLASS()
+class ASYMPTOMAGICKAL_API UHexGridChunk : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	UHexGridChunk();
+
+	virtual bool IsSupportedForNetworking() const override { return true; }
+
+	AHexGrid* GetGrid() const;
+
+	int32 GetChunkIndex() const { return ChunkIndex; }
+
+	/** Server only, called once right after the chunk was created */
+	void InitChunk(const int32 InChunkIndex);
+
+	UPROPERTY(Replicated)
+	FTileDataArray TileArray;
+
+private:
+	/** Initial only, so it fires once for every chunk object a client receives, including chunks that come back into relevancy */
+	UPROPERTY(ReplicatedUsing=OnRep_ChunkIndex)
+	int32 ChunkIndex = INDEX_NONE;
+
+	UFUNCTION()
+	void OnRep_ChunkIndex();
+};
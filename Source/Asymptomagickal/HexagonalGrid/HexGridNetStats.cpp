@@ -0,0 +1,10 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexGridNetStats.h"
+
+FHexGridNetStats& FHexGridNetStats::Get()
+{
+	static FHexGridNetStats Stats;
+	return Stats;
+}
@@ -0,0 +1,38 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Client side counters of the tile replication callbacks and the tile requests sent, game thread only.
+ * Read by the net soak recorder.
+ */
+struct ASYMPTOMAGICKAL_API FHexGridNetStats
+{
+	int64 NumAdds = 0;
+	int64 NumChanges = 0;
+	int64 NumRemoves = 0;
+	int64 NumReceives = 0;
+
+	/** Reliable tile request RPCs sent by UTileInteraction and the tiles they carried */
+	int64 NumRequestRPCs = 0;
+	int64 NumRequestedTiles = 0;
+
+	/** Time spent applying received tiles to the tile store and the meshes */
+	uint64 ApplyCycles = 0;
+
+	static FHexGridNetStats& Get();
+
+	void Reset() { *this = FHexGridNetStats(); }
+
+	/** Adds the lifetime of the scope to ApplyCycles */
+	struct FScopedApply
+	{
+		FScopedApply() : StartCycles(FPlatformTime::Cycles64()) {}
+		~FScopedApply() { Get().ApplyCycles += FPlatformTime::Cycles64() - StartCycles; }
+
+	private:
+		uint64 StartCycles;
+	};
+};
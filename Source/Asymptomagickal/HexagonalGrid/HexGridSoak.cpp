@@ -0,0 +1,387 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexGrid.h"
+
+#if !UE_BUILD_SHIPPING
+
+#include "EngineUtils.h"
+#include "Asymptomagickal/AsymLogChannels.h"
+#include "Asymptomagickal/Component/TileInteraction.h"
+#include "HexGridChunk.h"
+#include "HexGridNetStats.h"
+#include "Containers/Ticker.h"
+#include "Engine/Engine.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/FileManager.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+/**
+ * Net soak tooling for the hex grid, see the README for launching a server and headless clients over loopback.
+ * Asym.HexGrid.Soak drives seeded random tile change storms on the server, Asym.HexGrid.RequestSoak makes a client
+ * request random tile changes through its UTileInteraction, batched or as one reliable RPC per tile like before batching.
+ * Asym.HexGrid.NetStatsRecord makes every machine append its replication numbers to a CSV in Saved/Profiling/HexGrid.
+ * Packet loss and latency come from the engine's NetEmulation.* cvars or -PktLoss/-PktLag, Scripts/HexGridNetSoak.py
+ * launches a whole soak and combines the CSVs.
+ */
+class FHexGridSoak
+{
+public:
+	static FHexGridSoak& Get()
+	{
+		static FHexGridSoak Soak;
+		return Soak;
+	}
+
+	void StartSoak(UWorld* World, const float InEditsPerSecond, const float Seconds, const float DelaySeconds, const int32 Seed, FOutputDevice& Ar);
+
+	void StartRequestSoak(UWorld* World, const float InTilesPerSecond, const float Seconds, const float DelaySeconds, const int32 Seed,
+		const bool bInPerTileRPCs, FOutputDevice& Ar);
+
+	void StartRecording(UWorld* World, const float IntervalSeconds, FOutputDevice& Ar);
+
+private:
+	bool TickSoak(const float DeltaTime);
+	bool TickRequestSoak(const float DeltaTime);
+	bool TickRecording(const float DeltaTime);
+
+	/**
+	 * Tile request RPCs sent within the connection's last round trip, none of them can have been acknowledged yet.
+	 * Counted from the client's own sends, Iris keeps its reliable RPC queue private.
+	 */
+	int32 GetRequestRPCsInFlight(const UNetConnection* Connection) const;
+
+	void WriteConnectionRow(const UNetConnection* Connection, const int32 ConnectionIndex, const TCHAR* Role, const int32 NumReplicatedTiles);
+
+	/** Clients travel to the server after the startup commands ran, so the world is looked up on every tick */
+	static UWorld* FindGameWorld();
+
+	FTSTicker::FDelegateHandle SoakHandle;
+	FRandomStream SoakRandom;
+	float EditsPerSecond = 0.f;
+	double SoakStartTime = 0.0;
+	double SoakEndTime = 0.0;
+	float EditBudget = 0.f;
+	int64 NumEdits = 0;
+
+	FTSTicker::FDelegateHandle RequestSoakHandle;
+	FRandomStream RequestRandom;
+	float RequestTilesPerSecond = 0.f;
+	double RequestSoakStartTime = 0.0;
+	double RequestSoakEndTime = 0.0;
+	float RequestBudget = 0.f;
+	bool bPerTileRPCs = false;
+
+	/** Send time and number of the tile request RPCs of the last frames, for the in flight count */
+	TArray<TPair<double, int64>> RecentRequestRPCs;
+	int64 LastNumRequestRPCs = 0;
+
+	/** Highest in flight count sampled since the last recorded row */
+	int32 MaxRequestRPCsInFlight = 0;
+
+	FTSTicker::FDelegateHandle RecordHandle;
+	FString RecordFile;
+	double RecordStartTime = 0.0;
+};
+
+UWorld* FHexGridSoak::FindGameWorld()
+{
+	for (const FWorldContext& Context : GEngine->GetWorldContexts())
+	{
+		if (Context.WorldType == EWorldType::Game || Context.WorldType == EWorldType::PIE)
+		{
+			return Context.World();
+		}
+	}
+	return nullptr;
+}
+
+void FHexGridSoak::StartSoak(UWorld* World, const float InEditsPerSecond, const float Seconds, const float DelaySeconds, const int32 Seed, FOutputDevice& Ar)
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(SoakHandle);
+	SoakHandle.Reset();
+
+	if (!World || World->GetNetMode() == NM_Client || InEditsPerSecond <= 0.f || Seconds <= 0.f)
+	{
+		Ar.Log(TEXT("Asym.HexGrid.Soak stopped, it runs on the server with positive edits per second and duration"));
+		return;
+	}
+
+	SoakRandom.Initialize(Seed);
+	EditsPerSecond = InEditsPerSecond;
+	SoakStartTime = FPlatformTime::Seconds() + DelaySeconds;
+	SoakEndTime = SoakStartTime + Seconds;
+	EditBudget = 0.f;
+	NumEdits = 0;
+
+	SoakHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FHexGridSoak::TickSoak));
+
+	Ar.Logf(TEXT("HexGrid soak: %.0f edits/s for %.0fs after %.0fs, seed %d"), EditsPerSecond, Seconds, DelaySeconds, Seed);
+}
+
+bool FHexGridSoak::TickSoak(const float DeltaTime)
+{
+	UWorld* World = FindGameWorld();
+	const double Now = FPlatformTime::Seconds();
+	if (!World || Now >= SoakEndTime)
+	{
+		UE_LOG(LogAsym, Log, TEXT("HexGrid soak finished after %lld edits"), NumEdits);
+		SoakHandle.Reset();
+		return false;
+	}
+
+	if (Now < SoakStartTime)
+	{
+		return true;
+	}
+
+	EditBudget += EditsPerSecond * DeltaTime;
+	const int32 NumFrameEdits = FMath::FloorToInt32(EditBudget);
+	EditBudget -= NumFrameEdits;
+
+	for (TActorIterator<AHexGrid> It(World); It; ++It)
+	{
+		AHexGrid* Grid = *It;
+		if (Grid->TileStore.Num() == 0)
+		{
+			continue;
+		}
+
+		for (int32 Edit = 0; Edit < NumFrameEdits; ++Edit)
+		{
+			const int32 TileIndex = SoakRandom.RandHelper(Grid->TileStore.Num());
+			const FTileStateBits StateBits = static_cast<FTileStateBits>(1 << SoakRandom.RandHelper(AsymTileState::NumBits));
+			Grid->SetStateOnTiles(MakeArrayView(&TileIndex, 1), StateBits);
+		}
+		NumEdits += NumFrameEdits;
+	}
+
+	return true;
+}
+
+void FHexGridSoak::StartRequestSoak(UWorld* World, const float InTilesPerSecond, const float Seconds, const float DelaySeconds, const int32 Seed,
+	const bool bInPerTileRPCs, FOutputDevice& Ar)
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(RequestSoakHandle);
+	RequestSoakHandle.Reset();
+
+	if (!World || InTilesPerSecond <= 0.f || Seconds <= 0.f)
+	{
+		Ar.Log(TEXT("Asym.HexGrid.RequestSoak stopped, it runs on a client with positive tiles per second and duration"));
+		return;
+	}
+
+	RequestRandom.Initialize(Seed);
+	RequestTilesPerSecond = InTilesPerSecond;
+	RequestSoakStartTime = FPlatformTime::Seconds() + DelaySeconds;
+	RequestSoakEndTime = RequestSoakStartTime + Seconds;
+	RequestBudget = 0.f;
+	bPerTileRPCs = bInPerTileRPCs;
+	RecentRequestRPCs.Reset();
+	LastNumRequestRPCs = FHexGridNetStats::Get().NumRequestRPCs;
+
+	RequestSoakHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FHexGridSoak::TickRequestSoak));
+
+	Ar.Logf(TEXT("HexGrid request soak: %.0f tiles/s %s for %.0fs after %.0fs, seed %d"),
+		RequestTilesPerSecond, bPerTileRPCs ? TEXT("one RPC per tile") : TEXT("batched"), Seconds, DelaySeconds, Seed);
+}
+
+bool FHexGridSoak::TickRequestSoak(const float DeltaTime)
+{
+	const double Now = FPlatformTime::Seconds();
+	if (Now >= RequestSoakEndTime)
+	{
+		UE_LOG(LogAsym, Log, TEXT("HexGrid request soak finished after %lld request RPCs"), FHexGridNetStats::Get().NumRequestRPCs);
+		RequestSoakHandle.Reset();
+		return false;
+	}
+
+	// Started from the command line the client only joins the server later, it waits for that
+	UWorld* World = FindGameWorld();
+	if (!World)
+	{
+		return true;
+	}
+
+	// RPCs of the last frame, batched requests go out on the tick after they were made
+	const int64 NumRequestRPCs = FHexGridNetStats::Get().NumRequestRPCs;
+	if (NumRequestRPCs > LastNumRequestRPCs)
+	{
+		RecentRequestRPCs.Emplace(Now, NumRequestRPCs - LastNumRequestRPCs);
+		LastNumRequestRPCs = NumRequestRPCs;
+	}
+	// Round trips beyond a second mean the connection is saturated anyway
+	RecentRequestRPCs.RemoveAll([Now](const TPair<double, int64>& Sent) { return Now - Sent.Key > 1.0; });
+
+	const UNetDriver* NetDriver = World->GetNetDriver();
+	if (NetDriver && NetDriver->ServerConnection)
+	{
+		MaxRequestRPCsInFlight = FMath::Max(MaxRequestRPCsInFlight, GetRequestRPCsInFlight(NetDriver->ServerConnection));
+	}
+
+	if (Now < RequestSoakStartTime || World->GetNetMode() != NM_Client)
+	{
+		return true;
+	}
+
+	RequestBudget += RequestTilesPerSecond * DeltaTime;
+	const int32 NumFrameTiles = FMath::FloorToInt32(RequestBudget);
+	RequestBudget -= NumFrameTiles;
+
+	APlayerController* PlayerController = World->GetFirstPlayerController();
+	UTileInteraction* TileInteraction = PlayerController ? PlayerController->FindComponentByClass<UTileInteraction>() : nullptr;
+	TActorIterator<AHexGrid> GridIt(World);
+	if (!TileInteraction || !GridIt || GridIt->TileStore.Num() == 0)
+	{
+		return true;
+	}
+
+	AHexGrid* Grid = *GridIt;
+	for (int32 Tile = 0; Tile < NumFrameTiles; ++Tile)
+	{
+		const int32 TileIndex = RequestRandom.RandHelper(Grid->TileStore.Num());
+		const FTileStateBits StateBits = static_cast<FTileStateBits>(1 << RequestRandom.RandHelper(AsymTileState::NumBits));
+		TileInteraction->RequestTilesTagChange(Grid, {TileIndex}, AsymTileState::ToTags(StateBits));
+
+		if (bPerTileRPCs)
+		{
+			TileInteraction->FlushTileRequests();
+		}
+	}
+
+	return true;
+}
+
+int32 FHexGridSoak::GetRequestRPCsInFlight(const UNetConnection* Connection) const
+{
+	const double Now = FPlatformTime::Seconds();
+	int64 NumInFlight = 0;
+	for (const TPair<double, int64>& Sent : RecentRequestRPCs)
+	{
+		if (Now - Sent.Key <= Connection->AvgLag)
+		{
+			NumInFlight += Sent.Value;
+		}
+	}
+	return static_cast<int32>(NumInFlight);
+}
+
+void FHexGridSoak::StartRecording(UWorld* World, const float IntervalSeconds, FOutputDevice& Ar)
+{
+	FTSTicker::GetCoreTicker().RemoveTicker(RecordHandle);
+	RecordHandle.Reset();
+
+	if (!World || IntervalSeconds <= 0.f)
+	{
+		Ar.Log(TEXT("HexGrid net stats recording stopped"));
+		return;
+	}
+
+	RecordStartTime = FPlatformTime::Seconds();
+	FHexGridNetStats::Get().Reset();
+
+	const TCHAR* Role = World->GetNetMode() == NM_Client ? TEXT("Client") : TEXT("Server");
+	RecordFile = FPaths::Combine(FPaths::ProfilingDir(), TEXT("HexGrid"),
+		FString::Printf(TEXT("NetSoak-%s-%u-%s.csv"), Role, FPlatformProcess::GetCurrentProcessId(), *FDateTime::Now().ToString()));
+	FFileHelper::SaveStringToFile(TEXT("Time,Role,Connection,OutBytesPerSecond,InBytesPerSecond,OutPacketsLost,InPacketsLost,AvgLagMs,")
+		TEXT("ReplicatedTiles,Adds,Changes,Removes,Receives,ApplyMs,Edits,RequestRPCs,RequestedTiles,MaxRequestRPCsInFlight\n"), *RecordFile);
+
+	RecordHandle = FTSTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateRaw(this, &FHexGridSoak::TickRecording), IntervalSeconds);
+
+	Ar.Logf(TEXT("Recording HexGrid net stats every %.1fs to %s"), IntervalSeconds, *RecordFile);
+}
+
+bool FHexGridSoak::TickRecording(const float DeltaTime)
+{
+	const UWorld* World = FindGameWorld();
+	const UNetDriver* NetDriver = World ? World->GetNetDriver() : nullptr;
+	if (!NetDriver)
+	{
+		return true;
+	}
+
+	int32 NumReplicatedTiles = 0;
+	for (TActorIterator<AHexGrid> It(World); It; ++It)
+	{
+		for (const UHexGridChunk* Chunk : It->Chunks)
+		{
+			NumReplicatedTiles += Chunk ? Chunk->TileArray.Items.Num() : 0;
+		}
+	}
+
+	if (NetDriver->ServerConnection)
+	{
+		WriteConnectionRow(NetDriver->ServerConnection, 0, TEXT("Client"), NumReplicatedTiles);
+	}
+
+	for (int32 ConnectionIndex = 0; ConnectionIndex < NetDriver->ClientConnections.Num(); ++ConnectionIndex)
+	{
+		WriteConnectionRow(NetDriver->ClientConnections[ConnectionIndex], ConnectionIndex, TEXT("Server"), NumReplicatedTiles);
+	}
+
+	MaxRequestRPCsInFlight = 0;
+	return true;
+}
+
+void FHexGridSoak::WriteConnectionRow(const UNetConnection* Connection, const int32 ConnectionIndex, const TCHAR* Role, const int32 NumReplicatedTiles)
+{
+	if (!Connection)
+	{
+		return;
+	}
+
+	// Sampled every frame while a request soak runs, only at the row otherwise
+	const int32 RequestRPCsInFlight = FMath::Max(MaxRequestRPCsInFlight, GetRequestRPCsInFlight(Connection));
+
+	const FHexGridNetStats& Stats = FHexGridNetStats::Get();
+	const FString Row = FString::Printf(TEXT("%.2f,%s,%d,%d,%d,%d,%d,%.1f,%d,%lld,%lld,%lld,%lld,%.3f,%lld,%lld,%lld,%d\n"),
+		FPlatformTime::Seconds() - RecordStartTime, Role, ConnectionIndex,
+		Connection->OutBytesPerSecond, Connection->InBytesPerSecond, Connection->OutPacketsLost, Connection->InPacketsLost,
+		Connection->AvgLag * 1000.f, NumReplicatedTiles,
+		Stats.NumAdds, Stats.NumChanges, Stats.NumRemoves, Stats.NumReceives, FPlatformTime::ToMilliseconds64(Stats.ApplyCycles), NumEdits,
+		Stats.NumRequestRPCs, Stats.NumRequestedTiles, RequestRPCsInFlight);
+
+	FFileHelper::SaveStringToFile(Row, *RecordFile, FFileHelper::EEncodingOptions::AutoDetect, &IFileManager::Get(), FILEWRITE_Append);
+}
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice GHexGridSoakCommand(
+	TEXT("Asym.HexGrid.Soak"),
+	TEXT("Server only, changes random tiles of every grid. Args: EditsPerSecond Seconds [DelaySeconds] [Seed]. 0 edits stops a running soak"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		FHexGridSoak::Get().StartSoak(World,
+			Args.IsValidIndex(0) ? FCString::Atof(*Args[0]) : 0.f,
+			Args.IsValidIndex(1) ? FCString::Atof(*Args[1]) : 0.f,
+			Args.IsValidIndex(2) ? FCString::Atof(*Args[2]) : 0.f,
+			Args.IsValidIndex(3) ? FCString::Atoi(*Args[3]) : 0,
+			Ar);
+	}));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice GHexGridRequestSoakCommand(
+	TEXT("Asym.HexGrid.RequestSoak"),
+	TEXT("Client only, requests random tile changes through the player's tile interaction. ")
+	TEXT("Args: TilesPerSecond Seconds [DelaySeconds] [Seed] [PerTileRPCs]. PerTileRPCs 1 sends every tile as its own reliable RPC like before batching"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		FHexGridSoak::Get().StartRequestSoak(World,
+			Args.IsValidIndex(0) ? FCString::Atof(*Args[0]) : 0.f,
+			Args.IsValidIndex(1) ? FCString::Atof(*Args[1]) : 0.f,
+			Args.IsValidIndex(2) ? FCString::Atof(*Args[2]) : 0.f,
+			Args.IsValidIndex(3) ? FCString::Atoi(*Args[3]) : 0,
+			Args.IsValidIndex(4) && FCString::Atoi(*Args[4]) != 0,
+			Ar);
+	}));
+
+static FAutoConsoleCommandWithWorldArgsAndOutputDevice GHexGridNetStatsRecordCommand(
+	TEXT("Asym.HexGrid.NetStatsRecord"),
+	TEXT("Appends bandwidth, replication callback counts and tile apply time to a CSV. Args: IntervalSeconds, 0 stops"),
+	FConsoleCommandWithWorldArgsAndOutputDeviceDelegate::CreateLambda([](const TArray<FString>& Args, UWorld* World, FOutputDevice& Ar)
+	{
+		FHexGridSoak::Get().StartRecording(World, Args.IsValidIndex(0) ? FCString::Atof(*Args[0]) : 0.f, Ar);
+	}));
+
+#endif // !UE_BUILD_SHIPPING
@@ -3,10 +3,115 @@
 
 #include "HexInstancedStaticMeshComponent.h"
 
+#include "Engine/World.h"
+#include "TimerManager.h"
+
 
 UHexInstancedStaticMeshComponent::UHexInstancedStaticMeshComponent()
 {
 	PrimaryComponentTick.bCanEverTick = false;
-	NumCustomDataFloats = 1;
-	
-}
\ No newline at end of file
+	NumCustomDataFloats = NumTileCustomDataFloats;
+}
+
+void UHexInstancedStaticMeshComponent::QueueInstanceTransform(const int32 InstanceIndex, const FTransform& Transform)
+{
+	PendingTransforms.Add(InstanceIndex, Transform);
+	ScheduleFlush();
+}
+
+void UHexInstancedStaticMeshComponent::QueueCustomDataValue(const int32 InstanceIndex, const int32 CustomDataIndex, const float Value)
+{
+	check(CustomDataIndex >= 0 && CustomDataIndex < NumTileCustomDataFloats);
+	FindOrAddPendingCustomData(InstanceIndex).Values[CustomDataIndex] = Value;
+	ScheduleFlush();
+}
+
+void UHexInstancedStaticMeshComponent::QueueTileCustomData(const int32 InstanceIndex, const float Height, const uint8 StateBits, const float HeightOffset)
+{
+	FPendingCustomData& Pending = PendingCustomData.FindOrAdd(InstanceIndex);
+	Pending.Values[CustomDataHeight] = Height;
+	Pending.Values[CustomDataState] = StateBits;
+	Pending.Values[CustomDataHeightOffset] = HeightOffset;
+	ScheduleFlush();
+}
+
+UHexInstancedStaticMeshComponent::FPendingCustomData& UHexInstancedStaticMeshComponent::FindOrAddPendingCustomData(const int32 InstanceIndex)
+{
+	if (FPendingCustomData* Pending = PendingCustomData.Find(InstanceIndex))
+	{
+		return *Pending;
+	}
+
+	FPendingCustomData& Pending = PendingCustomData.Add(InstanceIndex);
+	for (int32 CustomDataIndex = 0; CustomDataIndex < NumTileCustomDataFloats; ++CustomDataIndex)
+	{
+		const int32 DataIndex = InstanceIndex * NumCustomDataFloats + CustomDataIndex;
+		Pending.Values[CustomDataIndex] = CustomDataIndex < NumCustomDataFloats && PerInstanceSMCustomData.IsValidIndex(DataIndex) ? PerInstanceSMCustomData[DataIndex] : 0.f;
+	}
+	return Pending;
+}
+
+void UHexInstancedStaticMeshComponent::FlushPendingUpdates()
+{
+	bFlushScheduled = false;
+
+	if (!HasPendingUpdates())
+	{
+		return;
+	}
+
+	if (PendingTransforms.Num() > 0)
+	{
+		PendingTransforms.KeySort(TLess<int32>());
+
+		int32 RunStart = INDEX_NONE;
+		for (const TPair<int32, FTransform>& Pending : PendingTransforms)
+		{
+			if (RunStart != INDEX_NONE && Pending.Key != RunStart + TransformRunScratch.Num())
+			{
+				BatchUpdateInstancesTransforms(RunStart, TransformRunScratch, false, false, true);
+				TransformRunScratch.Reset();
+			}
+
+			if (TransformRunScratch.Num() == 0)
+			{
+				RunStart = Pending.Key;
+			}
+			TransformRunScratch.Add(Pending.Value);
+		}
+
+		BatchUpdateInstancesTransforms(RunStart, TransformRunScratch, false, false, true);
+		TransformRunScratch.Reset();
+		PendingTransforms.Reset();
+	}
+
+	for (const TPair<int32, FPendingCustomData>& Pending : PendingCustomData)
+	{
+		SetCustomData(Pending.Key, MakeArrayView(Pending.Value.Values, FMath::Min<int32>(NumCustomDataFloats, NumTileCustomDataFloats)), false);
+	}
+	PendingCustomData.Reset();
+
+	MarkRenderStateDirty();
+}
+
+bool UHexInstancedStaticMeshComponent::ClearInstances()
+{
+	// Queued indices would point at the wrong instances after a clear
+	PendingTransforms.Reset();
+	PendingCustomData.Reset();
+
+	return Super::ClearInstances();
+}
+
+void UHexInstancedStaticMeshComponent::ScheduleFlush()
+{
+	// Editor utilities flush explicitly, only game worlds tick the timer manager reliably
+	UWorld* World = GetWorld();
+	if (bFlushScheduled || !World || !World->IsGameWorld())
+	{
+		return;
+	}
+
+	bFlushScheduled = true;
+	World->GetTimerManager().SetTimerForNextTick(this, &UHexInstancedStaticMeshComponent::FlushPendingUpdates);
+}
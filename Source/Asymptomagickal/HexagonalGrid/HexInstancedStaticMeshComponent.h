@@ -9,12 +9,63 @@
 #include "HexInstancedStaticMeshComponent.generated.h"
 
 
-
+/**
+ * ISM used by the hex grid. Instance changes can be queued and are flushed together with a single render state update,
+ * either explicitly or automatically on the next tick.
+ *
+ * Per instance custom data, for the tile material:
+ * 0 - tile height, 1 - tile state bits (AsymTileState), 2 - height offset the material adds on top of the instance transform
+ */
 UCLASS()
 class ASYMPTOMAGICKAL_API UHexInstancedStaticMeshComponent : public UInstancedStaticMeshComponent
 {
 	GENERATED_BODY()
 public:
 	UHexInstancedStaticMeshComponent();
-	
+
+	static constexpr int32 CustomDataHeight = 0;
+	static constexpr int32 CustomDataState = 1;
+	static constexpr int32 CustomDataHeightOffset = 2;
+	static constexpr int32 NumTileCustomDataFloats = 3;
+
+	/** Queues a local space transform for the instance, a later queue for the same instance replaces it */
+	void QueueInstanceTransform(const int32 InstanceIndex, const FTransform& Transform);
+
+	/** Queues a custom data write for the instance, a later write to the same value replaces it */
+	void QueueCustomDataValue(const int32 InstanceIndex, const int32 CustomDataIndex, const float Value);
+
+	/** Queues all tile custom data of the instance at once */
+	void QueueTileCustomData(const int32 InstanceIndex, const float Height, const uint8 StateBits, const float HeightOffset);
+
+	/**
+	 * Applies all queued changes, contiguous transform ranges go through BatchUpdateInstancesTransforms
+	 * and the custom data of each instance is written in one go
+	 */
+	void FlushPendingUpdates();
+
+	bool HasPendingUpdates() const { return PendingTransforms.Num() > 0 || PendingCustomData.Num() > 0; }
+
+	virtual bool ClearInstances() override;
+
+	/** Chunk of the owning grid this component renders, INDEX_NONE for the grid's root component */
+	int32 ChunkIndex = INDEX_NONE;
+
+private:
+	void ScheduleFlush();
+
+	struct FPendingCustomData
+	{
+		float Values[NumTileCustomDataFloats];
+	};
+
+	/** Pending custom data of the instance, starts out as the instance's current data */
+	FPendingCustomData& FindOrAddPendingCustomData(const int32 InstanceIndex);
+
+	TMap<int32, FTransform> PendingTransforms;
+	TMap<int32, FPendingCustomData> PendingCustomData;
+
+	// Reused between flushes to collect contiguous transform runs
+	TArray<FTransform> TransformRunScratch;
+
+	bool bFlushScheduled = false;
 };
@@ -0,0 +1,205 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexPathfinder.h"
+
+#include "HexTileStore.h"
+#include "Algo/Reverse.h"
+
+bool FHexPathfinder::FindPath(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const int32 StartTileIndex, const int32 GoalTileIndex,
+	const FHexPathQuery& Query, TArray<int32>& OutPath)
+{
+	OutPath.Reset();
+
+	if (Tiles.Num() != Layout.Num() || !Tiles.IsValidIndex(StartTileIndex) || !Tiles.IsValidIndex(GoalTileIndex))
+	{
+		return false;
+	}
+
+	// The start tile is where the agent already stands, only the tiles it moves onto are checked
+	if (!CanEnter(Tiles.GetState(GoalTileIndex), Query.Agent))
+	{
+		return false;
+	}
+
+	BeginQuery(Tiles.Num());
+
+	const FHexCoord GoalCoord = Layout.FromTileIndex(GoalTileIndex);
+
+	Costs[StartTileIndex] = 0.f;
+	Parents[StartTileIndex] = INDEX_NONE;
+	SeenStamps[StartTileIndex] = QueryStamp;
+	OpenHeap.HeapPush({static_cast<float>(FHexCoord::Distance(Layout.FromTileIndex(StartTileIndex), GoalCoord)), StartTileIndex});
+
+	int32 NumExpanded = 0;
+
+	while (OpenHeap.Num() > 0)
+	{
+		FOpenNode Node;
+		OpenHeap.HeapPop(Node, EAllowShrinking::No);
+
+		// Cheaper duplicates of a tile are pushed instead of updating the heap, the stale ones are skipped here
+		if (ClosedStamps[Node.TileIndex] == QueryStamp)
+		{
+			continue;
+		}
+		ClosedStamps[Node.TileIndex] = QueryStamp;
+
+		if (Node.TileIndex == GoalTileIndex)
+		{
+			for (int32 TileIndex = GoalTileIndex; TileIndex != INDEX_NONE; TileIndex = Parents[TileIndex])
+			{
+				OutPath.Add(TileIndex);
+			}
+			Algo::Reverse(OutPath);
+			return true;
+		}
+
+		if (Query.MaxSearchNodes > 0 && ++NumExpanded > Query.MaxSearchNodes)
+		{
+			break;
+		}
+
+		for (const FHexCoord& Neighbor : FHexCoord::Neighbors(Layout.FromTileIndex(Node.TileIndex)))
+		{
+			const int32 NeighborIndex = Layout.ToTileIndex(Neighbor);
+			if (NeighborIndex == INDEX_NONE || ClosedStamps[NeighborIndex] == QueryStamp || !CanStep(Tiles, Node.TileIndex, NeighborIndex, Query))
+			{
+				continue;
+			}
+
+			const float Cost = Costs[Node.TileIndex] + GetStepCost(Tiles, Node.TileIndex, NeighborIndex, Query);
+			if (SeenStamps[NeighborIndex] == QueryStamp && Cost >= Costs[NeighborIndex])
+			{
+				continue;
+			}
+
+			SeenStamps[NeighborIndex] = QueryStamp;
+			Costs[NeighborIndex] = Cost;
+			Parents[NeighborIndex] = Node.TileIndex;
+
+			// Every step costs at least 1, so the hex distance never overestimates
+			OpenHeap.HeapPush({Cost + FHexCoord::Distance(Neighbor, GoalCoord), NeighborIndex});
+		}
+	}
+
+	return false;
+}
+
+void FHexPathfinder::FindReachable(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const int32 StartTileIndex, const float MaxCost,
+	const FHexPathQuery& Query, TArray<int32>& OutTiles)
+{
+	OutTiles.Reset();
+
+	if (Tiles.Num() != Layout.Num() || !Tiles.IsValidIndex(StartTileIndex))
+	{
+		return;
+	}
+
+	BeginQuery(Tiles.Num());
+
+	Costs[StartTileIndex] = 0.f;
+	SeenStamps[StartTileIndex] = QueryStamp;
+	OpenHeap.HeapPush({0.f, StartTileIndex});
+
+	while (OpenHeap.Num() > 0)
+	{
+		FOpenNode Node;
+		OpenHeap.HeapPop(Node, EAllowShrinking::No);
+
+		if (ClosedStamps[Node.TileIndex] == QueryStamp)
+		{
+			continue;
+		}
+		ClosedStamps[Node.TileIndex] = QueryStamp;
+		OutTiles.Add(Node.TileIndex);
+
+		if (Query.MaxSearchNodes > 0 && OutTiles.Num() >= Query.MaxSearchNodes)
+		{
+			break;
+		}
+
+		for (const FHexCoord& Neighbor : FHexCoord::Neighbors(Layout.FromTileIndex(Node.TileIndex)))
+		{
+			const int32 NeighborIndex = Layout.ToTileIndex(Neighbor);
+			if (NeighborIndex == INDEX_NONE || ClosedStamps[NeighborIndex] == QueryStamp || !CanStep(Tiles, Node.TileIndex, NeighborIndex, Query))
+			{
+				continue;
+			}
+
+			const float Cost = Costs[Node.TileIndex] + GetStepCost(Tiles, Node.TileIndex, NeighborIndex, Query);
+			if (Cost > MaxCost || (SeenStamps[NeighborIndex] == QueryStamp && Cost >= Costs[NeighborIndex]))
+			{
+				continue;
+			}
+
+			SeenStamps[NeighborIndex] = QueryStamp;
+			Costs[NeighborIndex] = Cost;
+			OpenHeap.HeapPush({Cost, NeighborIndex});
+		}
+	}
+}
+
+bool FHexPathfinder::CanEnter(const FTileStateBits State, const EHexPathAgent Agent)
+{
+	if (State & AsymTileState::Permission_Locked)
+	{
+		return false;
+	}
+
+	if (State & AsymTileState::Permission_OnlyKing)
+	{
+		return Agent == EHexPathAgent::King;
+	}
+
+	if (State & AsymTileState::Permission_OnlyPlayers)
+	{
+		return Agent == EHexPathAgent::Player || Agent == EHexPathAgent::King;
+	}
+
+	return true;
+}
+
+bool FHexPathfinder::CanStep(const FHexTileStore& Tiles, const int32 FromTileIndex, const int32 ToTileIndex, const FHexPathQuery& Query)
+{
+	if (!CanEnter(Tiles.GetState(ToTileIndex), Query.Agent))
+	{
+		return false;
+	}
+
+	const float HeightDelta = Tiles.GetHeight(ToTileIndex) - Tiles.GetHeight(FromTileIndex);
+	if (Query.MaxStepUp >= 0.f && HeightDelta > Query.MaxStepUp)
+	{
+		return false;
+	}
+
+	return Query.MaxStepDown < 0.f || -HeightDelta <= Query.MaxStepDown;
+}
+
+float FHexPathfinder::GetStepCost(const FHexTileStore& Tiles, const int32 FromTileIndex, const int32 ToTileIndex, const FHexPathQuery& Query)
+{
+	return 1.f + Query.HeightCostScale * FMath::Abs(Tiles.GetHeight(ToTileIndex) - Tiles.GetHeight(FromTileIndex));
+}
+
+void FHexPathfinder::BeginQuery(const int32 NumTiles)
+{
+	if (Costs.Num() != NumTiles)
+	{
+		Costs.SetNumUninitialized(NumTiles);
+		Parents.SetNumUninitialized(NumTiles);
+		SeenStamps.Init(0, NumTiles);
+		ClosedStamps.Init(0, NumTiles);
+		// Duplicates can push more entries than there are tiles, the heap keeps whatever it grew to
+		OpenHeap.Reserve(NumTiles);
+	}
+
+	OpenHeap.Reset();
+
+	// On wrap around stale stamps could match again
+	if (++QueryStamp == 0)
+	{
+		FMemory::Memzero(SeenStamps.GetData(), SeenStamps.Num() * sizeof(uint32));
+		FMemory::Memzero(ClosedStamps.GetData(), ClosedStamps.Num() * sizeof(uint32));
+		QueryStamp = 1;
+	}
+}
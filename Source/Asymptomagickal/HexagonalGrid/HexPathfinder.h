@@ -0,0 +1,97 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexCoord.h"
+#include "HexTileState.h"
+#include "HexPathfinder.generated.h"
+
+struct FHexTileStore;
+
+/**
+ * Who walks the path, decides which permission tiles can be entered
+ */
+UENUM(BlueprintType)
+enum class EHexPathAgent : uint8
+{
+	/** Player pawns, may enter OnlyPlayers tiles */
+	Player,
+	/** The king, may enter OnlyKing and OnlyPlayers tiles */
+	King,
+	/** AI and everything else, only enters tiles open to all */
+	Other
+};
+
+/**
+ * Settings of a single path query
+ */
+USTRUCT(BlueprintType)
+struct FHexPathQuery
+{
+	GENERATED_BODY()
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding")
+	EHexPathAgent Agent = EHexPathAgent::Player;
+
+	/** Highest climb between neighboring tiles, negative for no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding")
+	float MaxStepUp = -1.f;
+
+	/** Highest drop between neighboring tiles, negative for no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding")
+	float MaxStepDown = -1.f;
+
+	/** Cost per unit of height difference, added to the cost of 1 per step */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding", meta=(ClampMin="0"))
+	float HeightCostScale = 0.f;
+
+	/** Tiles expanded before the search gives up, 0 for no limit */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category="Pathfinding", meta=(ClampMin="0"))
+	int32 MaxSearchNodes = 0;
+};
+
+/**
+ * A* over the hex grid's tile store. Costs, parents and the open heap are sized to the grid once and reused,
+ * tiles are marked as seen/closed with a per query stamp so no query clears or allocates anything.
+ * Not thread safe, every user owns its own instance.
+ */
+class ASYMPTOMAGICKAL_API FHexPathfinder
+{
+public:
+	/** Fills OutPath with the tile indices from start to goal (both included), returns false if the goal cannot be reached */
+	bool FindPath(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const int32 StartTileIndex, const int32 GoalTileIndex,
+		const FHexPathQuery& Query, TArray<int32>& OutPath);
+
+	/** Fills OutTiles with every tile reachable within MaxCost, ordered by cost and starting with the start tile */
+	void FindReachable(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const int32 StartTileIndex, const float MaxCost,
+		const FHexPathQuery& Query, TArray<int32>& OutTiles);
+
+	/** Permission check only, Locked tiles can never be entered */
+	static bool CanEnter(const FTileStateBits State, const EHexPathAgent Agent);
+
+	/** Permission and height check for a step between two neighboring tiles */
+	static bool CanStep(const FHexTileStore& Tiles, const int32 FromTileIndex, const int32 ToTileIndex, const FHexPathQuery& Query);
+
+	static float GetStepCost(const FHexTileStore& Tiles, const int32 FromTileIndex, const int32 ToTileIndex, const FHexPathQuery& Query);
+
+private:
+	/** Grows the pooled arrays to the grid and advances the stamp */
+	void BeginQuery(const int32 NumTiles);
+
+	struct FOpenNode
+	{
+		float EstimatedCost;
+		int32 TileIndex;
+
+		bool operator<(const FOpenNode& Other) const { return EstimatedCost < Other.EstimatedCost; }
+	};
+
+	TArray<float> Costs;
+	TArray<int32> Parents;
+	TArray<uint32> SeenStamps;
+	TArray<uint32> ClosedStamps;
+	TArray<FOpenNode> OpenHeap;
+
+	uint32 QueryStamp = 0;
+};
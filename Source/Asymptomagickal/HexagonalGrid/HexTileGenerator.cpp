@@ -0,0 +1,53 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexTileGenerator.h"
+
+void UHexTileGenerator_Noise::GenerateTile(const FHexGridLayout& Layout, const int32 TileIndex, const int32 Seed, float& InOutHeight,
+	FTileStateBits& InOutState) const
+{
+	// Sample in tile units so the look does not change with the tile radius, the seed shifts the sampled area
+	const FHexCoord Coord = Layout.FromTileIndex(TileIndex);
+	const FRandomStream Stream(Seed);
+	const FVector2D Offset(Stream.FRandRange(-10000.f, 10000.f), Stream.FRandRange(-10000.f, 10000.f));
+	const FVector2D Position = FVector2D(Coord.R + Coord.Q * 0.5f, Coord.Q * 0.5f * UE_SQRT_3) + Offset;
+
+	float Noise = 0.f;
+	float OctaveFrequency = Frequency;
+	float OctaveAmplitude = 1.f;
+	float AmplitudeSum = 0.f;
+
+	for (int32 Octave = 0; Octave < Octaves; ++Octave)
+	{
+		Noise += FMath::PerlinNoise2D(Position * OctaveFrequency) * OctaveAmplitude;
+		AmplitudeSum += OctaveAmplitude;
+		OctaveFrequency *= 2.f;
+		OctaveAmplitude *= 0.5f;
+	}
+
+	InOutHeight += Amplitude * Noise / AmplitudeSum;
+}
+
+void UHexTileGenerator_Rim::GenerateTile(const FHexGridLayout& Layout, const int32 TileIndex, const int32 Seed, float& InOutHeight,
+	FTileStateBits& InOutState) const
+{
+	if (!IsRimTile(Layout, TileIndex))
+	{
+		return;
+	}
+
+	InOutHeight = RandomForTile(Seed, TileIndex, MinHeight, MaxHeight);
+	if (bLockRim)
+	{
+		InOutState = AsymTileState::Permission_Locked;
+	}
+}
+
+bool UHexTileGenerator_Rim::IsRimTile(const FHexGridLayout& Layout, const int32 TileIndex) const
+{
+	const int32 Row = TileIndex / Layout.Columns;
+	const int32 Column = TileIndex % Layout.Columns;
+	const int32 BorderDistance = FMath::Min(FMath::Min(Row, Layout.Rows - 1 - Row), FMath::Min(Column, Layout.Columns - 1 - Column));
+
+	return BorderDistance < RimWidth;
+}
@@ -0,0 +1,91 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexCoord.h"
+#include "HexTileState.h"
+#include "UObject/Object.h"
+#include "HexTileGenerator.generated.h"
+
+/**
+ * Step of the procedural grid generation, AHexGrid runs its generators in order on every tile.
+ * Tiles are generated in parallel, so GenerateTile may only read the generator's own settings, and the result may only
+ * depend on the layout, the tile index and the seed so that server and clients generate the same board.
+ */
+UCLASS(Abstract, EditInlineNew, DefaultToInstanced, CollapseCategories)
+class ASYMPTOMAGICKAL_API UHexTileGenerator : public UObject
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GenerateTile(const FHexGridLayout& Layout, const int32 TileIndex, const int32 Seed, float& InOutHeight, FTileStateBits& InOutState) const
+		PURE_VIRTUAL(UHexTileGenerator::GenerateTile, );
+
+	/** Deterministic random value in [Min, Max) for the tile */
+	static float RandomForTile(const int32 Seed, const int32 TileIndex, const float Min, const float Max)
+	{
+		const FRandomStream Stream(static_cast<int32>(HashCombine(GetTypeHash(Seed), GetTypeHash(TileIndex))));
+		return Stream.FRandRange(Min, Max);
+	}
+
+	/**
+	 * Seed the generator at GeneratorIndex of a grid's generator list gets from the grid seed, every generator gets its own
+	 * so two random generators do not produce the same pattern
+	 */
+	static int32 GetGeneratorSeed(const int32 Seed, const int32 GeneratorIndex)
+	{
+		return static_cast<int32>(HashCombine(GetTypeHash(Seed), GetTypeHash(GeneratorIndex + 1)));
+	}
+};
+
+/**
+ * Adds fractal perlin noise over the tile positions, for rolling terrain
+ */
+UCLASS(DisplayName="Noise Height")
+class ASYMPTOMAGICKAL_API UHexTileGenerator_Noise : public UHexTileGenerator
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GenerateTile(const FHexGridLayout& Layout, const int32 TileIndex, const int32 Seed, float& InOutHeight, FTileStateBits& InOutState) const override;
+
+	/** Noise features per tile, lower values give wider hills */
+	UPROPERTY(EditAnywhere, Category="Noise", meta=(ClampMin="0.001"))
+	float Frequency = 0.08f;
+
+	UPROPERTY(EditAnywhere, Category="Noise")
+	float Amplitude = 150.f;
+
+	UPROPERTY(EditAnywhere, Category="Noise", meta=(ClampMin="1", ClampMax="8"))
+	int32 Octaves = 3;
+};
+
+/**
+ * Raises the tiles along the border of the grid into a wall
+ */
+UCLASS(DisplayName="Rim")
+class ASYMPTOMAGICKAL_API UHexTileGenerator_Rim : public UHexTileGenerator
+{
+	GENERATED_BODY()
+
+public:
+	virtual void GenerateTile(const FHexGridLayout& Layout, const int32 TileIndex, const int32 Seed, float& InOutHeight, FTileStateBits& InOutState) const override;
+
+	/** Decided in offset coordinates, world positions are never exact enough to compare */
+	bool IsRimTile(const FHexGridLayout& Layout, const int32 TileIndex) const;
+
+	/** Rows and columns from the border that count as rim */
+	UPROPERTY(EditAnywhere, Category="Rim", meta=(ClampMin="1"))
+	int32 RimWidth = 1;
+
+	UPROPERTY(EditAnywhere, Category="Rim")
+	float MinHeight = 2000.f;
+
+	UPROPERTY(EditAnywhere, Category="Rim")
+	float MaxHeight = 2400.f;
+
+	/** Marks rim tiles as Locked so nothing can path onto them */
+	UPROPERTY(EditAnywhere, Category="Rim")
+	bool bLockRim = false;
+};
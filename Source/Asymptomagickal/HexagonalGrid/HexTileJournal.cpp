@@ -0,0 +1,61 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexTileJournal.h"
+
+void FHexTileJournal::Init(const int32 InCapacity, const FHexTileStore& InBaseTiles)
+{
+	Changes.Reset();
+	Changes.SetNum(FMath::Max(InCapacity, 0));
+	NextSequence = 0;
+
+	// Shares the tile blocks, the first change folded into a block copies it once
+	BaseTiles = InBaseTiles;
+}
+
+void FHexTileJournal::Reset()
+{
+	Changes.Empty();
+	NextSequence = 0;
+	BaseTiles.Reset();
+}
+
+void FHexTileJournal::Record(const int32 TileIndex, const FTileStateBits OldStateBits, const FTileStateBits NewStateBits, AActor* Instigator)
+{
+	if (!IsEnabled())
+	{
+		return;
+	}
+
+	FHexTileChange& Change = Changes[NextSequence % Changes.Num()];
+
+	// The slot holds the oldest change, it leaves the journal and becomes part of the base
+	if (NextSequence >= Changes.Num())
+	{
+		BaseTiles.SetState(Change.TileIndex, Change.NewStateBits);
+	}
+
+	Change.Sequence = NextSequence++;
+	Change.Frame = static_cast<int64>(GFrameCounter);
+	Change.TileIndex = TileIndex;
+	Change.OldStateBits = OldStateBits;
+	Change.NewStateBits = NewStateBits;
+	Change.Instigator = Instigator;
+}
+
+bool FHexTileJournal::Replay(const int64 EndSequence, FHexTileStore& OutTiles) const
+{
+	if (EndSequence < GetFirstSequence() || EndSequence > NextSequence)
+	{
+		return false;
+	}
+
+	OutTiles = BaseTiles;
+	for (int64 Sequence = GetFirstSequence(); Sequence < EndSequence; ++Sequence)
+	{
+		const FHexTileChange& Change = Get(Sequence);
+		OutTiles.SetState(Change.TileIndex, Change.NewStateBits);
+	}
+
+	return true;
+}
@@ -0,0 +1,83 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexTileState.h"
+#include "HexTileStore.h"
+#include "HexTileJournal.generated.h"
+
+/**
+ * One state change of one tile on the server
+ */
+USTRUCT(BlueprintType)
+struct FHexTileChange
+{
+	GENERATED_BODY()
+
+	/** Position in the journal, counts every change since the grid was built */
+	UPROPERTY(BlueprintReadOnly, Category="HexGrid|Journal")
+	int64 Sequence = 0;
+
+	/** Server frame (GFrameCounter) the change was made in */
+	UPROPERTY(BlueprintReadOnly, Category="HexGrid|Journal")
+	int64 Frame = 0;
+
+	UPROPERTY(BlueprintReadOnly, Category="HexGrid|Journal")
+	int32 TileIndex = INDEX_NONE;
+
+	UPROPERTY(BlueprintReadOnly, Category="HexGrid|Journal")
+	uint8 OldStateBits = AsymTileState::None;
+
+	UPROPERTY(BlueprintReadOnly, Category="HexGrid|Journal")
+	uint8 NewStateBits = AsymTileState::None;
+
+	/** Whoever requested the change, null for server side changes */
+	UPROPERTY(BlueprintReadOnly, Category="HexGrid|Journal")
+	TWeakObjectPtr<AActor> Instigator;
+};
+
+/**
+ * Append only ring buffer of the most recent tile changes. Changes that fall out of the ring are folded into the base tiles,
+ * so the base plus the retained changes always reproduce the current board.
+ * Memory is reserved in Init, recording never allocates.
+ */
+class ASYMPTOMAGICKAL_API FHexTileJournal
+{
+public:
+	/** Starts an empty journal on top of the given board */
+	void Init(const int32 InCapacity, const FHexTileStore& InBaseTiles);
+
+	void Reset();
+
+	void Record(const int32 TileIndex, const FTileStateBits OldStateBits, const FTileStateBits NewStateBits, AActor* Instigator);
+
+	bool IsEnabled() const { return Changes.Num() > 0; }
+
+	/** Oldest change still in the journal */
+	int64 GetFirstSequence() const { return FMath::Max<int64>(NextSequence - Changes.Num(), 0); }
+
+	/** Sequence the next change will get */
+	int64 GetNextSequence() const { return NextSequence; }
+
+	bool Contains(const int64 Sequence) const { return Sequence >= GetFirstSequence() && Sequence < NextSequence; }
+
+	const FHexTileChange& Get(const int64 Sequence) const
+	{
+		check(Contains(Sequence));
+		return Changes[Sequence % Changes.Num()];
+	}
+
+	/** Board at GetFirstSequence, before every retained change */
+	const FHexTileStore& GetBaseTiles() const { return BaseTiles; }
+
+	/** Rebuilds the board as it was right before the change with EndSequence, false if that is older than the journal */
+	bool Replay(const int64 EndSequence, FHexTileStore& OutTiles) const;
+
+private:
+	/** Fixed size ring, the change with sequence S lives at S % Num */
+	TArray<FHexTileChange> Changes;
+	int64 NextSequence = 0;
+
+	FHexTileStore BaseTiles;
+};
@@ -0,0 +1,63 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexTileState.h"
+
+#include "Asymptomagickal/AsymGameplayTags.h"
+
+namespace AsymTileState
+{
+	TConstArrayView<FGameplayTag> GetRegisteredTags()
+	{
+		// Built on first use, native tags are registered by then
+		static const FGameplayTag RegisteredTags[] =
+		{
+			AsymGameplayTags::Tile_Permission_Locked,
+			AsymGameplayTags::Tile_Permission_OnlyKing,
+			AsymGameplayTags::Tile_Permission_OnlyPlayers,
+			AsymGameplayTags::Tile_Permission_All,
+		};
+		static_assert(UE_ARRAY_COUNT(RegisteredTags) == NumBits, "Update NumBits and the bit constants when registering tile tags");
+		static_assert(NumBits <= sizeof(FTileStateBits) * 8, "FTileStateBits is too narrow for the registered tile tags");
+
+		return RegisteredTags;
+	}
+
+	FTileStateBits GetBit(const FGameplayTag& Tag)
+	{
+		const TConstArrayView<FGameplayTag> RegisteredTags = GetRegisteredTags();
+		for (int32 Bit = 0; Bit < RegisteredTags.Num(); ++Bit)
+		{
+			if (RegisteredTags[Bit] == Tag)
+			{
+				return static_cast<FTileStateBits>(1 << Bit);
+			}
+		}
+		return None;
+	}
+
+	FTileStateBits FromTags(const FGameplayTagContainer& Tags)
+	{
+		FTileStateBits Bits = None;
+		for (const FGameplayTag& Tag : Tags)
+		{
+			Bits |= GetBit(Tag);
+		}
+		return Bits;
+	}
+
+	FGameplayTagContainer ToTags(const FTileStateBits Bits)
+	{
+		FGameplayTagContainer Tags;
+
+		const TConstArrayView<FGameplayTag> RegisteredTags = GetRegisteredTags();
+		for (int32 Bit = 0; Bit < RegisteredTags.Num(); ++Bit)
+		{
+			if (Bits & (1 << Bit))
+			{
+				Tags.AddTag(RegisteredTags[Bit]);
+			}
+		}
+		return Tags;
+	}
+}
@@ -0,0 +1,43 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GameplayTagContainer.h"
+
+/**
+ * Compact per tile state, one bit per registered tile tag.
+ * Tiles store and replicate these bits, gameplay tags are only used at the API boundary (ITileInterface::SetTagsOnTile).
+ */
+using FTileStateBits = uint8;
+
+namespace AsymTileState
+{
+	/*
+	 *	Bits of the registered tags, keep in sync with the order in GetRegisteredTags
+	 */
+	constexpr FTileStateBits None = 0;
+	constexpr FTileStateBits Permission_Locked = 1 << 0;
+	constexpr FTileStateBits Permission_OnlyKing = 1 << 1;
+	constexpr FTileStateBits Permission_OnlyPlayers = 1 << 2;
+	constexpr FTileStateBits Permission_All = 1 << 3;
+
+	constexpr FTileStateBits Default = Permission_All;
+
+	/** Number of bits in use, all higher bits are always zero */
+	constexpr int32 NumBits = 4;
+
+	/** Mask of all bits in use */
+	constexpr FTileStateBits AllBits = (1 << NumBits) - 1;
+
+	/** Tile tags that can be represented in FTileStateBits, the index in the view is the bit */
+	ASYMPTOMAGICKAL_API TConstArrayView<FGameplayTag> GetRegisteredTags();
+
+	/** Bit for a registered tag, None if the tag is not registered */
+	ASYMPTOMAGICKAL_API FTileStateBits GetBit(const FGameplayTag& Tag);
+
+	/** Tags that are not registered are dropped */
+	ASYMPTOMAGICKAL_API FTileStateBits FromTags(const FGameplayTagContainer& Tags);
+
+	ASYMPTOMAGICKAL_API FGameplayTagContainer ToTags(const FTileStateBits Bits);
+}
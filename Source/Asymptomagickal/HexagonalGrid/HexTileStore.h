@@ -0,0 +1,101 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexTileState.h"
+
+/**
+ * Complete tile state of a grid on this machine, indexed by tile index.
+ * The replicated TileArray only carries tiles that differ from the procedural default, this store is what every query reads.
+ *
+ * Tiles are kept in fixed size blocks that are shared between copies of the store and copied on the first write,
+ * so taking a snapshot for worker threads costs one reference per block and a mutation only copies the block it touches.
+ */
+struct FHexTileStore
+{
+	void Init(const int32 InNumTiles)
+	{
+		Blocks.Reset();
+		NumTiles = InNumTiles;
+
+		for (int32 BlockIndex = 0; BlockIndex < (NumTiles + BlockSize - 1) / BlockSize; ++BlockIndex)
+		{
+			const TSharedRef<FBlock, ESPMode::ThreadSafe> Block = MakeShared<FBlock, ESPMode::ThreadSafe>();
+			FMemory::Memzero(Block->Heights, sizeof(Block->Heights));
+			FMemory::Memset(Block->States, AsymTileState::Default, sizeof(Block->States));
+			Blocks.Add(Block);
+		}
+
+		++Version;
+	}
+
+	/** Takes the tiles from plain arrays, both need one entry per tile */
+	void Init(const TConstArrayView<float> InHeights, const TConstArrayView<FTileStateBits> InStates)
+	{
+		check(InHeights.Num() == InStates.Num());
+		Init(InHeights.Num());
+
+		for (int32 BlockIndex = 0; BlockIndex < Blocks.Num(); ++BlockIndex)
+		{
+			const int32 FirstTile = BlockIndex * BlockSize;
+			const int32 NumBlockTiles = FMath::Min(BlockSize, NumTiles - FirstTile);
+			FMemory::Memcpy(Blocks[BlockIndex]->Heights, InHeights.GetData() + FirstTile, NumBlockTiles * sizeof(float));
+			FMemory::Memcpy(Blocks[BlockIndex]->States, InStates.GetData() + FirstTile, NumBlockTiles * sizeof(FTileStateBits));
+		}
+	}
+
+	void Reset()
+	{
+		Blocks.Reset();
+		NumTiles = 0;
+		++Version;
+	}
+
+	int32 Num() const { return NumTiles; }
+	bool IsValidIndex(const int32 TileIndex) const { return TileIndex >= 0 && TileIndex < NumTiles; }
+
+	float GetHeight(const int32 TileIndex) const { return Blocks[TileIndex >> BlockShift]->Heights[TileIndex & BlockMask]; }
+	FTileStateBits GetState(const int32 TileIndex) const { return Blocks[TileIndex >> BlockShift]->States[TileIndex & BlockMask]; }
+
+	void SetHeight(const int32 TileIndex, const float Height)
+	{
+		GetMutableBlock(TileIndex).Heights[TileIndex & BlockMask] = Height;
+		++Version;
+	}
+
+	void SetState(const int32 TileIndex, const FTileStateBits State)
+	{
+		GetMutableBlock(TileIndex).States[TileIndex & BlockMask] = State;
+		++Version;
+	}
+
+	/** Changes with every mutation, a snapshot with the same version holds the same tiles */
+	uint32 GetVersion() const { return Version; }
+
+private:
+	static constexpr int32 BlockShift = 10;
+	static constexpr int32 BlockSize = 1 << BlockShift;
+	static constexpr int32 BlockMask = BlockSize - 1;
+
+	struct FBlock
+	{
+		float Heights[BlockSize];
+		FTileStateBits States[BlockSize];
+	};
+
+	/** Copies the block first if a snapshot still references it */
+	FBlock& GetMutableBlock(const int32 TileIndex)
+	{
+		TSharedRef<FBlock, ESPMode::ThreadSafe>& Block = Blocks[TileIndex >> BlockShift];
+		if (!Block.IsUnique())
+		{
+			Block = MakeShared<FBlock, ESPMode::ThreadSafe>(*Block);
+		}
+		return *Block;
+	}
+
+	TArray<TSharedRef<FBlock, ESPMode::ThreadSafe>> Blocks;
+	int32 NumTiles = 0;
+	uint32 Version = 0;
+};
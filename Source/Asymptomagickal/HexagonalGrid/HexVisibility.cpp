@@ -0,0 +1,103 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexVisibility.h"
+
+#include "HexTileStore.h"
+
+/** Lines that run exactly along an edge between two hexes are rounded to both sides, sight is blocked only if both block it */
+static constexpr double GLineNudge = 1e-6;
+
+void FHexVisibility::ComputeFieldOfView(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const int32 ObserverTileIndex, const int32 Range,
+	const float EyeHeight, TArray<int32>& OutTiles)
+{
+	OutTiles.Reset();
+
+	if (Range < 0 || Tiles.Num() != Layout.Num() || !Tiles.IsValidIndex(ObserverTileIndex))
+	{
+		return;
+	}
+
+	const FHexCoord Observer = Layout.FromTileIndex(ObserverTileIndex);
+	const float EyeZ = Tiles.GetHeight(ObserverTileIndex) + EyeHeight;
+
+	// Every hex within Range fits into the square of axial offsets around the observer
+	const int32 Width = 2 * Range + 1;
+	Horizons.SetNumUninitialized(Width * Width, EAllowShrinking::No);
+
+	auto HorizonAt = [this, &Observer, Range, Width](const FHexCoord& Coord) -> float&
+	{
+		return Horizons[(Coord.Q - Observer.Q + Range) * Width + Coord.R - Observer.R + Range];
+	};
+
+	HorizonAt(Observer) = -UE_MAX_FLT;
+	OutTiles.Add(ObserverTileIndex);
+
+	for (int32 Ring = 1; Ring <= Range; ++Ring)
+	{
+		// The sight line to a hex of this ring crosses the previous ring at this fraction of the way
+		const double Alpha = (Ring - 1.0) / Ring;
+
+		for (const FHexCoord& Coord : FHexCoord::Ring(Observer, Ring))
+		{
+			const double FracQ = Observer.Q + (Coord.Q - Observer.Q) * Alpha;
+			const double FracR = Observer.R + (Coord.R - Observer.R) * Alpha;
+			const float FrontHorizon = FMath::Min(HorizonAt(FHexCoord::Round(FracQ + GLineNudge, FracR + GLineNudge)),
+				HorizonAt(FHexCoord::Round(FracQ - GLineNudge, FracR - GLineNudge)));
+
+			const int32 TileIndex = Layout.ToTileIndex(Coord);
+			if (TileIndex == INDEX_NONE)
+			{
+				// Outside of the grid nothing blocks sight
+				HorizonAt(Coord) = FrontHorizon;
+				continue;
+			}
+
+			const float Slope = (Tiles.GetHeight(TileIndex) - EyeZ) / Ring;
+			if (Slope >= FrontHorizon)
+			{
+				OutTiles.Add(TileIndex);
+			}
+
+			HorizonAt(Coord) = FMath::Max(FrontHorizon, Slope);
+		}
+	}
+}
+
+bool FHexVisibility::HasLineOfSight(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const int32 FromTileIndex, const int32 ToTileIndex,
+	const float EyeHeight)
+{
+	if (Tiles.Num() != Layout.Num() || !Tiles.IsValidIndex(FromTileIndex) || !Tiles.IsValidIndex(ToTileIndex))
+	{
+		return false;
+	}
+
+	const FHexCoord From = Layout.FromTileIndex(FromTileIndex);
+	const FHexCoord To = Layout.FromTileIndex(ToTileIndex);
+	const int32 Distance = FHexCoord::Distance(From, To);
+
+	const float FromZ = Tiles.GetHeight(FromTileIndex) + EyeHeight;
+	const float ToZ = Tiles.GetHeight(ToTileIndex);
+
+	auto BlocksSight = [&Layout, &Tiles](const FHexCoord& Coord, const float LineZ)
+	{
+		const int32 TileIndex = Layout.ToTileIndex(Coord);
+		return TileIndex != INDEX_NONE && Tiles.GetHeight(TileIndex) > LineZ;
+	};
+
+	for (int32 Step = 1; Step < Distance; ++Step)
+	{
+		const double Alpha = static_cast<double>(Step) / Distance;
+		const double FracQ = From.Q + (To.Q - From.Q) * Alpha;
+		const double FracR = From.R + (To.R - From.R) * Alpha;
+		const float LineZ = FMath::Lerp(FromZ, ToZ, static_cast<float>(Alpha));
+
+		if (BlocksSight(FHexCoord::Round(FracQ + GLineNudge, FracR + GLineNudge), LineZ)
+			&& BlocksSight(FHexCoord::Round(FracQ - GLineNudge, FracR - GLineNudge), LineZ))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
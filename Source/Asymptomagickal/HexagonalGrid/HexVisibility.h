@@ -0,0 +1,31 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HexCoord.h"
+
+struct FHexTileStore;
+
+/**
+ * Line of sight and field of view over the tile heights, no physics involved.
+ * Sight is measured from EyeHeight above the observer's tile to the top of the target tile.
+ */
+class ASYMPTOMAGICKAL_API FHexVisibility
+{
+public:
+	/**
+	 * Shadowcasting over hex rings: every tile keeps the steepest slope seen on the way to it from the observer, a tile is
+	 * visible if its top reaches above the slope of the tiles in front of it. Fills OutTiles from the observer outwards.
+	 */
+	void ComputeFieldOfView(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const int32 ObserverTileIndex, const int32 Range,
+		const float EyeHeight, TArray<int32>& OutTiles);
+
+	/** Walks the hex line between both tiles, false if a tile in between rises above the sight line */
+	static bool HasLineOfSight(const FHexGridLayout& Layout, const FHexTileStore& Tiles, const int32 FromTileIndex, const int32 ToTileIndex,
+		const float EyeHeight);
+
+private:
+	/** Steepest slope towards every hex around the observer, reused between queries */
+	TArray<float> Horizons;
+};
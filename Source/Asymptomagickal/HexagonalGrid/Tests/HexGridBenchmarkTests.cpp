@@ -0,0 +1,274 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexGridTestUtilities.h"
+#include "Asymptomagickal/Tests/AsymTestUtilities.h"
+#include "HAL/IConsoleManager.h"
+#include "Iris/ReplicationState/ReplicationStateDescriptor.h"
+#include "Iris/ReplicationState/ReplicationStateDescriptorBuilder.h"
+#include "Misc/AutomationTest.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_COMPLEX_AUTOMATION_TEST(FHexGridBenchmarkTest, "Asym.HexGrid.Benchmark",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+namespace HexGridBenchmark
+{
+	/** Tile operations per measurement, enough to get stable averages on small boards */
+	constexpr int32 NumOperations = 100000;
+
+	/** Net updates per replication measurement and tile changes between two dirty updates */
+	constexpr int32 NumNetUpdates = 300;
+	constexpr int32 ChangesPerNetUpdate = 32;
+
+	struct FResult
+	{
+		FString Metric;
+		double Value;
+		FString Unit;
+	};
+
+	/** Serialize cost of one replication mode over a number of net updates */
+	struct FReplicationCost
+	{
+		double Seconds = 0.0;
+		int64 NumBits = 0;
+		int64 NumCalls = 0;
+	};
+
+	/** One net update of every chunk array, the writer polls the arrays like its replication mode does */
+	void ReplicateChunks(const TArray<TObjectPtr<UHexGridChunk>>& Chunks, FTileArrayIrisWriter& Writer, FReplicationCost& Cost)
+	{
+		const int64 NumPolledArrays = Writer.GetNumPolledArrays();
+		const double StartTime = FPlatformTime::Seconds();
+		for (UHexGridChunk* Chunk : Chunks)
+		{
+			Cost.NumBits += Writer.Write(Chunk->TileArray);
+		}
+		Cost.Seconds += FPlatformTime::Seconds() - StartTime;
+		Cost.NumCalls += Writer.GetNumPolledArrays() - NumPolledArrays;
+	}
+
+	/**
+	 * Whether Iris replicates the chunk's tile array push based, the replication layout reads Asym.HexGrid.PushModel.
+	 * The descriptors are built without a registry, so every call builds them again.
+	 */
+	bool IsTileArrayPushBased()
+	{
+		using namespace UE::Net;
+
+		const FProperty* TileArrayProperty = UHexGridChunk::StaticClass()->FindPropertyByName(GET_MEMBER_NAME_CHECKED(UHexGridChunk, TileArray));
+		FReplicationStateDescriptorBuilder::FResult Descriptors;
+		FReplicationStateDescriptorBuilder::CreateDescriptorsForClass(Descriptors, UHexGridChunk::StaticClass(), FReplicationStateDescriptorBuilder::FParameters());
+		for (const TRefCountPtr<const FReplicationStateDescriptor>& Descriptor : Descriptors)
+		{
+			for (uint32 MemberIndex = 0; MemberIndex < Descriptor->MemberCount; ++MemberIndex)
+			{
+				if (Descriptor->MemberProperties[MemberIndex] == TileArrayProperty)
+				{
+					return EnumHasAnyFlags(Descriptor->Traits, EReplicationStateTraits::HasPushBasedDirtiness);
+				}
+			}
+		}
+		return false;
+	}
+
+	void WriteResults(const int32 BoardSize, const TArray<FResult>& Results)
+	{
+		const int32 NumTiles = BoardSize * BoardSize;
+		FString Csv = TEXT("BoardSize,Tiles,Metric,Value,Unit\n");
+		FString Json = TEXT("[\n");
+
+		for (int32 ResultIndex = 0; ResultIndex < Results.Num(); ++ResultIndex)
+		{
+			const FResult& Result = Results[ResultIndex];
+			Csv += FString::Printf(TEXT("%d,%d,%s,%f,%s\n"), BoardSize, NumTiles, *Result.Metric, Result.Value, *Result.Unit);
+			Json += FString::Printf(TEXT("\t{\"boardSize\": %d, \"tiles\": %d, \"metric\": \"%s\", \"value\": %f, \"unit\": \"%s\"}%s\n"),
+				BoardSize, NumTiles, *Result.Metric, Result.Value, *Result.Unit, ResultIndex + 1 < Results.Num() ? TEXT(",") : TEXT(""));
+		}
+		Json += TEXT("]\n");
+
+		const FString BaseName = FPaths::Combine(FPaths::ProfilingDir(), TEXT("HexGrid"),
+			FString::Printf(TEXT("HexGridBenchmark-%d-%s"), BoardSize, *FDateTime::Now().ToString()));
+		FFileHelper::SaveStringToFile(Csv, *(BaseName + TEXT(".csv")));
+		FFileHelper::SaveStringToFile(Json, *(BaseName + TEXT(".json")));
+	}
+}
+
+void FHexGridBenchmarkTest::GetTests(TArray<FString>& OutBeautifiedNames, TArray<FString>& OutTestCommands) const
+{
+	for (const int32 BoardSize : {64, 256, 512})
+	{
+		OutBeautifiedNames.Add(FString::Printf(TEXT("%dx%d"), BoardSize, BoardSize));
+		OutTestCommands.Add(FString::FromInt(BoardSize));
+	}
+}
+
+/**
+ * Builds a fresh server grid of the board size in a private world and measures generation, build, lookups, tile changes,
+ * the instance flush and the Iris serialization of the chunks through FTileDataNetSerializer. Replication is measured
+ * with the layout Iris builds with Asym.HexGrid.PushModel off and on, for the same changes, for updates where tiles
+ * changed and updates where nothing did.
+ * Results are reported and written as CSV and JSON to Saved/Profiling/HexGrid.
+ */
+bool FHexGridBenchmarkTest::RunTest(const FString& Parameters)
+{
+	using namespace HexGridBenchmark;
+
+	const int32 BoardSize = FCString::Atoi(*Parameters);
+	if (!TestTrue(TEXT("Board size"), BoardSize > 0))
+	{
+		return false;
+	}
+
+	AsymTests::FScopedTestWorld TestWorld;
+
+	TArray<FResult> Results;
+	const auto AddResult = [this, &Results](const TCHAR* Metric, const double Value, const TCHAR* Unit)
+	{
+		Results.Add({Metric, Value, Unit});
+		AddInfo(FString::Printf(TEXT("%s: %.3f %s"), Metric, Value, Unit));
+	};
+
+	FHexGridTestSettings Settings;
+	Settings.Rows = BoardSize;
+	Settings.Columns = BoardSize;
+	Settings.Seed = BoardSize;
+	Settings.bBuild = false;
+	AHexGrid* Grid = FHexGridTestAccess::SpawnGrid(TestWorld.GetWorld(), Settings);
+
+	const FHexGridLayout Layout = Grid->GetLayout();
+	const int32 NumTiles = Layout.Num();
+
+	double StartTime = FPlatformTime::Seconds();
+	TArray<float> Heights;
+	TArray<FTileStateBits> States;
+	Grid->GenerateTiles(Layout, Heights, States);
+	AddResult(TEXT("Generation"), (FPlatformTime::Seconds() - StartTime) * 1000.0, TEXT("ms"));
+
+	// BeginPlay builds the tile store, the chunk meshes and the replicated chunks
+	StartTime = FPlatformTime::Seconds();
+	Grid->FinishSpawning(FTransform::Identity);
+	AddResult(TEXT("Build"), (FPlatformTime::Seconds() - StartTime) * 1000.0, TEXT("ms"));
+
+	const TArray<TObjectPtr<UHexGridChunk>>& Chunks = FHexGridTestAccess::GetChunks(*Grid);
+
+	FRandomStream Random(BoardSize);
+	TArray<int32> TileIndices;
+	TileIndices.SetNumUninitialized(NumOperations);
+	for (int32& TileIndex : TileIndices)
+	{
+		TileIndex = Random.RandHelper(NumTiles);
+	}
+
+	StartTime = FPlatformTime::Seconds();
+	int32 NumWrongTiles = 0;
+	for (const int32 TileIndex : TileIndices)
+	{
+		NumWrongTiles += Grid->GetTileDataFromItem(TileIndex).TileIndex != TileIndex;
+	}
+	AddResult(TEXT("TileLookup"), (FPlatformTime::Seconds() - StartTime) * 1e9 / TileIndices.Num(), TEXT("ns"));
+	TestEqual(TEXT("Tiles looked up wrongly"), NumWrongTiles, 0);
+
+	// Every mode replicates the way Iris lays out the chunk with the cvar set to it
+	IConsoleVariable* PushModelCVar = IConsoleManager::Get().FindConsoleVariable(TEXT("Asym.HexGrid.PushModel"));
+	const bool bConfiguredPushModel = PushModelCVar->GetBool();
+	const auto IsPushBasedWith = [this, PushModelCVar](const bool bPushModel)
+	{
+		PushModelCVar->Set(bPushModel, ECVF_SetByCode);
+		const bool bPushBased = IsTileArrayPushBased();
+		TestTrue(FString::Printf(TEXT("Tile array push based with Asym.HexGrid.PushModel %d"), bPushModel), bPushBased == bPushModel);
+		return bPushBased;
+	};
+	FTileArrayIrisWriter PolledWriter(IsPushBasedWith(false));
+	FTileArrayIrisWriter PushWriter(IsPushBasedWith(true));
+	PushModelCVar->Set(bConfiguredPushModel, ECVF_SetByCode);
+
+	// The initial state is what a joining client gets, every later update of these writers is a delta
+	FReplicationCost InitialCost;
+	FReplicationCost UnmeasuredCost;
+	ReplicateChunks(Chunks, PolledWriter, InitialCost);
+	ReplicateChunks(Chunks, PushWriter, UnmeasuredCost);
+	AddResult(TEXT("IrisInitialSize"), InitialCost.NumBits / 8.0, TEXT("bytes"));
+	AddResult(TEXT("IrisInitialTime"), InitialCost.Seconds * 1000.0, TEXT("ms"));
+
+	// Every tile change goes through the chunk arrays, the journal and the instance queue like a gameplay change
+	StartTime = FPlatformTime::Seconds();
+	for (int32 Operation = 0; Operation < TileIndices.Num(); ++Operation)
+	{
+		Grid->SetStateOnTiles(MakeArrayView(&TileIndices[Operation], 1), Operation & 1 ? AsymTileState::Permission_Locked : AsymTileState::Default);
+	}
+	AddResult(TEXT("TagChangeThroughput"), TileIndices.Num() / (FPlatformTime::Seconds() - StartTime), TEXT("tiles/s"));
+
+	StartTime = FPlatformTime::Seconds();
+	Grid->SetStateOnTiles(TileIndices, AsymTileState::Permission_OnlyPlayers);
+	AddResult(TEXT("BatchedTagChangeThroughput"), TileIndices.Num() / (FPlatformTime::Seconds() - StartTime), TEXT("tiles/s"));
+
+	StartTime = FPlatformTime::Seconds();
+	for (UHexInstancedStaticMeshComponent* ChunkMesh : FHexGridTestAccess::GetChunkMeshes(*Grid))
+	{
+		ChunkMesh->FlushPendingUpdates();
+	}
+	AddResult(TEXT("InstanceFlush"), (FPlatformTime::Seconds() - StartTime) * 1000.0, TEXT("ms"));
+
+	// Catch both writers up on the bulk changes above, they are not part of the steady state
+	ReplicateChunks(Chunks, PolledWriter, UnmeasuredCost);
+	ReplicateChunks(Chunks, PushWriter, UnmeasuredCost);
+
+	FReplicationCost PolledDirty;
+	FReplicationCost PushDirty;
+	for (int32 Update = 0; Update < NumNetUpdates; ++Update)
+	{
+		for (int32 Change = 0; Change < ChangesPerNetUpdate; ++Change)
+		{
+			const int32 TileIndex = Random.RandHelper(NumTiles);
+			const FTileStateBits StateBits = static_cast<FTileStateBits>(1 << Random.RandHelper(AsymTileState::NumBits));
+			Grid->SetStateOnTiles(MakeArrayView(&TileIndex, 1), StateBits);
+		}
+
+		ReplicateChunks(Chunks, PolledWriter, PolledDirty);
+		ReplicateChunks(Chunks, PushWriter, PushDirty);
+	}
+
+	FReplicationCost PolledClean;
+	FReplicationCost PushClean;
+	for (int32 Update = 0; Update < NumNetUpdates; ++Update)
+	{
+		ReplicateChunks(Chunks, PolledWriter, PolledClean);
+		ReplicateChunks(Chunks, PushWriter, PushClean);
+	}
+
+	const auto AddReplicationResults = [&AddResult](const TCHAR* Mode, const FReplicationCost& Cost)
+	{
+		AddResult(*FString::Printf(TEXT("%sSerializeTime"), Mode), Cost.Seconds * 1e6 / NumNetUpdates, TEXT("us/update"));
+		AddResult(*FString::Printf(TEXT("%sSerializeSize"), Mode), Cost.NumBits / 8.0 / NumNetUpdates, TEXT("bytes/update"));
+		AddResult(*FString::Printf(TEXT("%sPolledArrays"), Mode), static_cast<double>(Cost.NumCalls) / NumNetUpdates, TEXT("arrays/update"));
+	};
+	AddReplicationResults(TEXT("PolledDirty"), PolledDirty);
+	AddReplicationResults(TEXT("PushDirty"), PushDirty);
+	AddReplicationResults(TEXT("PolledClean"), PolledClean);
+	AddReplicationResults(TEXT("PushClean"), PushClean);
+
+	// Polling compares every item, push based only the items the tile changes marked dirty, a change missing its
+	// MarkItemDirty would only reach the polled client
+	TestEqual(TEXT("Push based replication finds every change polling finds"), PushDirty.NumBits, PolledDirty.NumBits);
+	TestTrue(TEXT("Dirty updates send the changes"), PolledDirty.NumBits > 0);
+	TestTrue(TEXT("Dirty push based updates poll no more arrays"), PushDirty.NumCalls <= PolledDirty.NumCalls);
+	TestEqual(TEXT("Clean polled updates poll every array"), PolledClean.NumCalls, static_cast<int64>(NumNetUpdates) * Chunks.Num());
+	TestEqual(TEXT("Clean polled updates send nothing"), PolledClean.NumBits, static_cast<int64>(0));
+	TestEqual(TEXT("Clean push based updates poll no array"), PushClean.NumCalls, static_cast<int64>(0));
+
+	// The replication layout of the running game follows the configured cvar, the numbers above cover both modes
+	AddResult(TEXT("PushModelEnabled"), bConfiguredPushModel ? 1.0 : 0.0, TEXT("bool"));
+
+	WriteResults(BoardSize, Results);
+
+	Grid->Destroy();
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
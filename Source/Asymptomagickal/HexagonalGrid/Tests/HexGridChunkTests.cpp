@@ -0,0 +1,112 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexGridTestUtilities.h"
+#include "Asymptomagickal/Tests/AsymTestUtilities.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHexGridChunkThroughputTest, "Asym.HexGrid.Chunks.TagChangeThroughput",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+/**
+ * Changes 1000 random tiles per second of simulated time on a 128x128 board, once kept in a single tile array
+ * (ChunkSize 0) and once split into 16x16 chunks. Every net update replicates every tile array through Iris' tile
+ * serializer, in the mode Asym.HexGrid.PushModel is configured for.
+ * A single tile change has to serialize exactly one array and the chunks must not send more per update than the
+ * single array does for the same changes.
+ */
+bool FHexGridChunkThroughputTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 BoardSize = 128;
+	static constexpr int32 ChangesPerSecond = 1000;
+	static constexpr int32 NetUpdatesPerSecond = 30;
+	static constexpr int32 Seconds = 10;
+
+	AsymTests::FScopedTestWorld TestWorld;
+
+	const bool bPushModel = IConsoleManager::Get().FindConsoleVariable(TEXT("Asym.HexGrid.PushModel"))->GetBool();
+	TMap<int32, int64> NumBitsByChunkSize;
+
+	for (const int32 ChunkSize : {0, 16})
+	{
+		FHexGridTestSettings Settings;
+		Settings.Rows = BoardSize;
+		Settings.Columns = BoardSize;
+		Settings.ChunkSize = ChunkSize;
+		AHexGrid* Grid = FHexGridTestAccess::SpawnGrid(TestWorld.GetWorld(), Settings);
+		const TArray<TObjectPtr<UHexGridChunk>>& Chunks = FHexGridTestAccess::GetChunks(*Grid);
+		const int32 NumTiles = Grid->GetLayout().Num();
+
+		// The initial state is what a joining client gets, not part of the steady state
+		FTileArrayIrisWriter IrisWriter(bPushModel);
+		for (UHexGridChunk* Chunk : Chunks)
+		{
+			IrisWriter.Write(Chunk->TileArray);
+		}
+
+		const auto WriteUpdate = [&Chunks, &IrisWriter](int64& OutNumBits, int32& OutNumWrittenArrays)
+		{
+			for (UHexGridChunk* Chunk : Chunks)
+			{
+				const int64 ArrayBits = IrisWriter.Write(Chunk->TileArray);
+				OutNumBits += ArrayBits;
+				OutNumWrittenArrays += ArrayBits > 0;
+			}
+		};
+
+		const int32 SingleTileIndex = NumTiles / 2;
+		const FTileStateBits SingleTileState = Grid->GetTileStore().GetState(SingleTileIndex) == AsymTileState::Default
+			? AsymTileState::Permission_Locked
+			: AsymTileState::Default;
+		Grid->SetStateOnTiles(MakeArrayView(&SingleTileIndex, 1), SingleTileState);
+		int64 SingleTileBits = 0;
+		int32 NumSingleTileArrays = 0;
+		WriteUpdate(SingleTileBits, NumSingleTileArrays);
+		TestEqual(TEXT("Arrays a single tile change serializes"), NumSingleTileArrays, 1);
+
+		FRandomStream Random(BoardSize);
+		double ChangeSeconds = 0.0;
+		double SerializeSeconds = 0.0;
+		int64 NumBits = 0;
+		int32 NumSerializedArrays = 0;
+
+		for (int32 Update = 0; Update < Seconds * NetUpdatesPerSecond; ++Update)
+		{
+			const int32 NumUpdateChanges = (Update + 1) * ChangesPerSecond / NetUpdatesPerSecond - Update * ChangesPerSecond / NetUpdatesPerSecond;
+
+			double StartTime = FPlatformTime::Seconds();
+			for (int32 Change = 0; Change < NumUpdateChanges; ++Change)
+			{
+				const int32 TileIndex = Random.RandHelper(NumTiles);
+				const FTileStateBits StateBits = static_cast<FTileStateBits>(1 << Random.RandHelper(AsymTileState::NumBits));
+				Grid->SetStateOnTiles(MakeArrayView(&TileIndex, 1), StateBits);
+			}
+			ChangeSeconds += FPlatformTime::Seconds() - StartTime;
+
+			StartTime = FPlatformTime::Seconds();
+			WriteUpdate(NumBits, NumSerializedArrays);
+			SerializeSeconds += FPlatformTime::Seconds() - StartTime;
+		}
+
+		const int32 NumChanges = Seconds * ChangesPerSecond;
+		AddInfo(FString::Printf(TEXT("%s (%d arrays): %.0f changes/s applied, %.3f ms serializing per second, %.1f bytes per update, %.1f arrays written per update, %lld bits for a single tile"),
+			ChunkSize > 0 ? TEXT("Chunked") : TEXT("Single array"), Chunks.Num(),
+			NumChanges / ChangeSeconds, SerializeSeconds * 1000.0 / Seconds, NumBits / 8.0 / (Seconds * NetUpdatesPerSecond),
+			static_cast<double>(NumSerializedArrays) / (Seconds * NetUpdatesPerSecond), SingleTileBits));
+
+		TestTrue(TEXT("Tile changes were serialized"), NumBits > 0);
+		NumBitsByChunkSize.Add(ChunkSize, NumBits);
+
+		Grid->Destroy();
+	}
+
+	// Both boards got the same changes, the chunks only add a header per dirty chunk and save on the item indices
+	TestTrue(TEXT("Chunked bytes per update do not exceed the single array's"), NumBitsByChunkSize[16] <= NumBitsByChunkSize[0]);
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
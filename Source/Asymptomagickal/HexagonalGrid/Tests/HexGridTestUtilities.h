@@ -0,0 +1,232 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Asymptomagickal/HexagonalGrid/HexGrid.h"
+#include "Asymptomagickal/HexagonalGrid/HexGridChunk.h"
+#include "Asymptomagickal/HexagonalGrid/HexInstancedStaticMeshComponent.h"
+#include "Asymptomagickal/HexagonalGrid/HexTileGenerator.h"
+#include "Asymptomagickal/HexagonalGrid/TileDataNetSerializer.h"
+#include "Engine/World.h"
+#include "Iris/Serialization/NetBitStreamUtil.h"
+#include "Iris/Serialization/NetBitStreamWriter.h"
+#include "Iris/Serialization/NetSerializationContext.h"
+
+/**
+ * Grid settings the tests build with, everything else keeps the class defaults
+ */
+struct FHexGridTestSettings
+{
+	int32 Rows = 64;
+	int32 Columns = 64;
+	int32 ChunkSize = 16;
+	int32 Seed = 0;
+	bool bReplicateSparseTiles = true;
+
+	/** Generators with their class defaults, in order */
+	TArray<TSubclassOf<UHexTileGenerator>> GeneratorClasses;
+
+	/** False leaves the spawn deferred, the grid has its settings but never began play, for tests of the generation alone */
+	bool bBuild = true;
+};
+
+/**
+ * Test access to the grid internals, AHexGrid befriends it
+ */
+class FHexGridTestAccess
+{
+public:
+	/**
+	 * Spawns and builds a server grid without instance collision and chunk relevancy, the world has to have begun play.
+	 * Unbuilt grids have to be destroyed by the test.
+	 */
+	static AHexGrid* SpawnGrid(UWorld* World, const FHexGridTestSettings& Settings)
+	{
+		AHexGrid* Grid = World->SpawnActorDeferred<AHexGrid>(AHexGrid::StaticClass(), FTransform::Identity);
+		Grid->Rows = Settings.Rows;
+		Grid->Columns = Settings.Columns;
+		Grid->ChunkSize = Settings.ChunkSize;
+		Grid->Seed = Settings.Seed;
+		Grid->bReplicateSparseTiles = Settings.bReplicateSparseTiles;
+		Grid->bEnableInstanceCollision = false;
+		Grid->ChunkRelevancyDistance = 0.f;
+		for (const TSubclassOf<UHexTileGenerator>& GeneratorClass : Settings.GeneratorClasses)
+		{
+			Grid->Generators.Add(NewObject<UHexTileGenerator>(Grid, GeneratorClass));
+		}
+
+		if (Settings.bBuild)
+		{
+			Grid->FinishSpawning(FTransform::Identity);
+		}
+		return Grid;
+	}
+
+	static const TArray<TObjectPtr<UHexGridChunk>>& GetChunks(const AHexGrid& Grid) { return Grid.Chunks; }
+	static const TArray<TObjectPtr<UHexInstancedStaticMeshComponent>>& GetChunkMeshes(const AHexGrid& Grid) { return Grid.ChunkMeshes; }
+
+	/** Editor preview on the root ISMC, see AHexGrid::CreateHexGrid */
+	static UHexInstancedStaticMeshComponent* GetPreviewMesh(const AHexGrid& Grid) { return Grid.ISMC; }
+	static void CreateHexGrid(const AHexGrid& Grid) { Grid.CreateHexGrid(); }
+	static void RandomizeHeight(const AHexGrid& Grid) { Grid.RandomizeHeight(); }
+	static void RaiseRim(const AHexGrid& Grid) { Grid.RaiseRim(); }
+};
+
+/**
+ * Replicates tile arrays the way Iris does for one connection that acknowledges every update right away, every Write
+ * is one net update of the array. The items go through FTileDataNetSerializer, a changed item is sent as a delta
+ * against the state the connection has.
+ * Polled, every update quantizes all items and compares them with IsEqual to find the changes. Push based, an array
+ * is only polled after the fast array was marked dirty, which is what reaches Iris' dirty tracking, and only its items
+ * with a new replication key are compared.
+ */
+class FTileArrayIrisWriter
+{
+public:
+	explicit FTileArrayIrisWriter(const bool bInPushModel)
+		: Serializer(GetSerializer())
+		, bPushModel(bInPushModel)
+	{
+	}
+
+	/** Bits the update sends for the array, 0 if nothing changed since the last update */
+	int64 Write(const FTileDataArray& TileArray)
+	{
+		using namespace UE::Net;
+
+		FArrayState& State = ArrayStates.FindOrAdd(&TileArray);
+		if (bPushModel && State.bWritten && State.ArrayReplicationKey == TileArray.ArrayReplicationKey)
+		{
+			return 0;
+		}
+		++NumPolledArrays;
+
+		const int32 NumItems = TileArray.Items.Num();
+		const int32 NumSentItems = State.ItemKeys.Num();
+		const uint32 Stride = Serializer.QuantizedTypeSize;
+
+		FNetSerializationContext Context;
+		ChangedItems.Reset();
+		ChangedStates.SetNumUninitialized(NumItems * Stride, EAllowShrinking::No);
+		for (int32 ItemIndex = 0; ItemIndex < NumItems; ++ItemIndex)
+		{
+			const FTileData& Item = TileArray.Items[ItemIndex];
+			if (bPushModel && ItemIndex < NumSentItems && State.ItemKeys[ItemIndex] == Item.ReplicationKey)
+			{
+				continue;
+			}
+
+			uint8* Quantized = ChangedStates.GetData() + ChangedItems.Num() * Stride;
+			FNetQuantizeArgs QuantizeArgs;
+			QuantizeArgs.NetSerializerConfig = Serializer.DefaultConfig;
+			QuantizeArgs.Source = NetSerializerValuePointer(&Item);
+			QuantizeArgs.Target = NetSerializerValuePointer(Quantized);
+			Serializer.Quantize(Context, QuantizeArgs);
+
+			if (ItemIndex < NumSentItems)
+			{
+				FNetIsEqualArgs IsEqualArgs;
+				IsEqualArgs.NetSerializerConfig = Serializer.DefaultConfig;
+				IsEqualArgs.Source0 = NetSerializerValuePointer(Quantized);
+				IsEqualArgs.Source1 = NetSerializerValuePointer(State.SentStates.GetData() + ItemIndex * Stride);
+				IsEqualArgs.bStateIsQuantized = true;
+				if (Serializer.IsEqual(Context, IsEqualArgs))
+				{
+					State.ItemKeys[ItemIndex] = Item.ReplicationKey;
+					continue;
+				}
+			}
+			ChangedItems.Add(ItemIndex);
+		}
+
+		const bool bFirstWrite = !State.bWritten;
+		State.bWritten = true;
+		State.ArrayReplicationKey = TileArray.ArrayReplicationKey;
+		State.ItemKeys.SetNumZeroed(NumItems);
+		State.SentStates.SetNumZeroed(NumItems * Stride);
+		if (ChangedItems.IsEmpty() && NumItems == NumSentItems && !bFirstWrite)
+		{
+			return 0;
+		}
+
+		// The item count if it changed, then every changed item as its distance to the previous one and its state, the
+		// object header of the replication system is not part of it
+		Buffer.SetNumUninitialized(4 + NumItems * 6, EAllowShrinking::No);
+		FNetBitStreamWriter BitWriter;
+		BitWriter.InitBytes(Buffer.GetData(), Buffer.Num() * sizeof(uint32));
+		FNetSerializationContext WriteContext(&BitWriter);
+
+		if (BitWriter.WriteBool(bFirstWrite || NumItems != NumSentItems))
+		{
+			WritePackedUint32(&BitWriter, NumItems);
+		}
+		int32 PrevItemIndex = -1;
+		for (int32 ChangedIndex = 0; ChangedIndex < ChangedItems.Num(); ++ChangedIndex)
+		{
+			const int32 ItemIndex = ChangedItems[ChangedIndex];
+			BitWriter.WriteBool(true);
+			WritePackedUint32(&BitWriter, ItemIndex - PrevItemIndex - 1);
+			PrevItemIndex = ItemIndex;
+
+			const uint8* Quantized = ChangedStates.GetData() + ChangedIndex * Stride;
+			uint8* Sent = State.SentStates.GetData() + ItemIndex * Stride;
+			if (ItemIndex < NumSentItems)
+			{
+				FNetSerializeDeltaArgs SerializeArgs;
+				SerializeArgs.NetSerializerConfig = Serializer.DefaultConfig;
+				SerializeArgs.Source = NetSerializerValuePointer(Quantized);
+				SerializeArgs.Prev = NetSerializerValuePointer(Sent);
+				Serializer.SerializeDelta(WriteContext, SerializeArgs);
+			}
+			else
+			{
+				FNetSerializeArgs SerializeArgs;
+				SerializeArgs.NetSerializerConfig = Serializer.DefaultConfig;
+				SerializeArgs.Source = NetSerializerValuePointer(Quantized);
+				Serializer.Serialize(WriteContext, SerializeArgs);
+			}
+
+			FMemory::Memcpy(Sent, Quantized, Stride);
+			State.ItemKeys[ItemIndex] = TileArray.Items[ItemIndex].ReplicationKey;
+		}
+		BitWriter.WriteBool(false);
+
+		BitWriter.CommitWrites();
+		check(!WriteContext.HasErrorOrOverflow());
+		return BitWriter.GetPosBits();
+	}
+
+	/** Arrays whose items were quantized and compared, polled replication does that for every array every update */
+	int64 GetNumPolledArrays() const { return NumPolledArrays; }
+
+private:
+	static const UE::Net::FNetSerializer& GetSerializer()
+	{
+		using namespace UE::Net;
+		return UE_NET_GET_SERIALIZER(FTileDataNetSerializer);
+	}
+
+	/** What the connection has of one array */
+	struct FArrayState
+	{
+		bool bWritten = false;
+		int32 ArrayReplicationKey = 0;
+		TArray<int32> ItemKeys;
+		TArray<uint8> SentStates;
+	};
+
+	const UE::Net::FNetSerializer& Serializer;
+	bool bPushModel;
+	int64 NumPolledArrays = 0;
+
+	TMap<const FTileDataArray*, FArrayState> ArrayStates;
+	TArray<int32> ChangedItems;
+	TArray<uint8> ChangedStates;
+	TArray<uint32> Buffer;
+};
+
+#endif // WITH_DEV_AUTOMATION_TESTS
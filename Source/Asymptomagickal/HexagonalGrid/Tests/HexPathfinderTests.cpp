@@ -0,0 +1,178 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "Asymptomagickal/HexagonalGrid/HexPathfinder.h"
+#include "Asymptomagickal/HexagonalGrid/HexTileStore.h"
+#include "Asymptomagickal/Tests/AsymTestUtilities.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHexPathfinderFrameTest, "Asym.HexGrid.Pathfinder.QueriesPerFrame",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+/**
+ * Runs frames of 1000 FindPath queries on a 256x256 board with rough terrain and scattered permission tiles.
+ * Goals lie within a move's reach of the start like gameplay and AI ask for. Every path has to be walkable and no query
+ * may allocate once the pathfinder and the path array are warmed up.
+ */
+bool FHexPathfinderFrameTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 BoardSize = 256;
+	static constexpr int32 QueriesPerFrame = 1000;
+	static constexpr int32 NumFrames = 10;
+	static constexpr int32 MaxQueryDistance = 24;
+	static constexpr double FrameBudgetMs = 1000.0 / 60.0;
+
+	const FHexGridLayout Layout(BoardSize, BoardSize, 50.f);
+
+	FRandomStream Random(BoardSize);
+
+	TArray<float> Heights;
+	TArray<FTileStateBits> States;
+	Heights.SetNumUninitialized(Layout.Num());
+	States.SetNumUninitialized(Layout.Num());
+	for (int32 TileIndex = 0; TileIndex < Layout.Num(); ++TileIndex)
+	{
+		Heights[TileIndex] = Random.FRandRange(0.f, 100.f);
+
+		const float Roll = Random.FRand();
+		States[TileIndex] = Roll < 0.1f ? AsymTileState::Permission_Locked
+			: Roll < 0.15f ? AsymTileState::Permission_OnlyKing
+			: Roll < 0.25f ? AsymTileState::Permission_OnlyPlayers
+			: AsymTileState::Default;
+	}
+
+	FHexTileStore Tiles;
+	Tiles.Init(Heights, States);
+
+	FHexPathQuery Query;
+	Query.Agent = EHexPathAgent::Player;
+	Query.MaxStepUp = 80.f;
+	Query.HeightCostScale = 0.01f;
+
+	// Start and goal pairs are picked up front, picking them is not part of the measurement
+	TArray<TPair<int32, int32>> Pairs;
+	Pairs.Reserve(QueriesPerFrame * NumFrames);
+	while (Pairs.Num() < QueriesPerFrame * NumFrames)
+	{
+		const int32 StartTileIndex = Random.RandHelper(Layout.Num());
+		const FHexCoord Offset(Random.RandRange(-MaxQueryDistance, MaxQueryDistance), Random.RandRange(-MaxQueryDistance, MaxQueryDistance));
+		const int32 GoalTileIndex = Layout.ToTileIndex(Layout.FromTileIndex(StartTileIndex) + Offset);
+		if (GoalTileIndex != INDEX_NONE && Offset.Length() <= MaxQueryDistance)
+		{
+			Pairs.Emplace(StartTileIndex, GoalTileIndex);
+		}
+	}
+
+	FHexPathfinder Pathfinder;
+	TArray<int32> Path;
+	Path.Reserve(Layout.Num());
+	Pathfinder.FindPath(Layout, Tiles, Pairs[0].Key, Pairs[0].Value, Query, Path);
+
+	if (!AsymTests::FScopedAllocationCounter::IsSupported())
+	{
+		AddWarning(TEXT("Allocations cannot be counted on this platform"));
+	}
+
+	int32 NumFound = 0;
+	int32 NumInvalidPaths = 0;
+	int64 NumPathTiles = 0;
+	double SlowestFrameMs = 0.0;
+	double TotalMs = 0.0;
+	int64 NumAllocations = 0;
+
+	for (int32 Frame = 0; Frame < NumFrames; ++Frame)
+	{
+		AsymTests::FScopedAllocationCounter AllocationCounter;
+		const double StartTime = FPlatformTime::Seconds();
+
+		for (int32 QueryIndex = Frame * QueriesPerFrame; QueryIndex < (Frame + 1) * QueriesPerFrame; ++QueryIndex)
+		{
+			const TPair<int32, int32>& Pair = Pairs[QueryIndex];
+			if (!Pathfinder.FindPath(Layout, Tiles, Pair.Key, Pair.Value, Query, Path))
+			{
+				continue;
+			}
+
+			++NumFound;
+			NumPathTiles += Path.Num();
+
+			bool bValid = Path[0] == Pair.Key && Path.Last() == Pair.Value;
+			for (int32 Step = 1; bValid && Step < Path.Num(); ++Step)
+			{
+				bValid = FHexCoord::Distance(Layout.FromTileIndex(Path[Step - 1]), Layout.FromTileIndex(Path[Step])) == 1
+					&& FHexPathfinder::CanStep(Tiles, Path[Step - 1], Path[Step], Query);
+			}
+			NumInvalidPaths += !bValid;
+		}
+
+		const double FrameMs = (FPlatformTime::Seconds() - StartTime) * 1000.0;
+		SlowestFrameMs = FMath::Max(SlowestFrameMs, FrameMs);
+		TotalMs += FrameMs;
+		NumAllocations += AllocationCounter.GetNumAllocations();
+	}
+
+	AddInfo(FString::Printf(TEXT("%d queries per frame on %dx%d: %.2f ms average, %.2f ms slowest frame, %d of %d found, %.1f tiles per path"),
+		QueriesPerFrame, BoardSize, BoardSize, TotalMs / NumFrames, SlowestFrameMs, NumFound, QueriesPerFrame * NumFrames,
+		NumFound > 0 ? static_cast<double>(NumPathTiles) / NumFound : 0.0));
+
+	TestTrue(TEXT("Paths were found"), NumFound > 0);
+	TestEqual(TEXT("Paths that are not walkable"), NumInvalidPaths, 0);
+	if (AsymTests::FScopedAllocationCounter::IsSupported())
+	{
+		TestEqual(TEXT("Heap allocations of the queries"), NumAllocations, static_cast<int64>(0));
+	}
+
+	// Timings depend on the machine and the build configuration, only a blown frame is worth flagging
+	if (TotalMs / NumFrames > FrameBudgetMs)
+	{
+		AddWarning(FString::Printf(TEXT("%d queries take %.2f ms per frame, more than a 60 Hz frame"), QueriesPerFrame, TotalMs / NumFrames));
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHexPathfinderPermissionTest, "Asym.HexGrid.Pathfinder.Permissions",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FHexPathfinderPermissionTest::RunTest(const FString& Parameters)
+{
+	TestFalse(TEXT("Nobody enters locked tiles"), FHexPathfinder::CanEnter(AsymTileState::Permission_Locked, EHexPathAgent::King));
+	TestTrue(TEXT("The king enters king tiles"), FHexPathfinder::CanEnter(AsymTileState::Permission_OnlyKing, EHexPathAgent::King));
+	TestFalse(TEXT("Players do not enter king tiles"), FHexPathfinder::CanEnter(AsymTileState::Permission_OnlyKing, EHexPathAgent::Player));
+	TestTrue(TEXT("The king enters player tiles"), FHexPathfinder::CanEnter(AsymTileState::Permission_OnlyPlayers, EHexPathAgent::King));
+	TestFalse(TEXT("Others do not enter player tiles"), FHexPathfinder::CanEnter(AsymTileState::Permission_OnlyPlayers, EHexPathAgent::Other));
+	TestTrue(TEXT("Others enter open tiles"), FHexPathfinder::CanEnter(AsymTileState::Default, EHexPathAgent::Other));
+
+	// A wall of locked tiles across a 8x8 board, only the king tile in the middle lets agents through
+	const FHexGridLayout Layout(8, 8, 50.f);
+	FHexTileStore Tiles;
+	Tiles.Init(Layout.Num());
+	for (int32 Row = 0; Row < Layout.Rows; ++Row)
+	{
+		Tiles.SetState(Layout.ToTileIndex(FHexCoord::FromOffset(Row, 4)), Row == 4 ? AsymTileState::Permission_OnlyKing : AsymTileState::Permission_Locked);
+	}
+
+	const int32 StartTileIndex = Layout.ToTileIndex(FHexCoord::FromOffset(4, 0));
+	const int32 GoalTileIndex = Layout.ToTileIndex(FHexCoord::FromOffset(4, 7));
+
+	FHexPathfinder Pathfinder;
+	TArray<int32> Path;
+	FHexPathQuery Query;
+
+	Query.Agent = EHexPathAgent::Player;
+	TestFalse(TEXT("Players cannot cross the wall"), Pathfinder.FindPath(Layout, Tiles, StartTileIndex, GoalTileIndex, Query, Path));
+
+	Query.Agent = EHexPathAgent::King;
+	if (TestTrue(TEXT("The king crosses the wall"), Pathfinder.FindPath(Layout, Tiles, StartTileIndex, GoalTileIndex, Query, Path)))
+	{
+		TestTrue(TEXT("The king's path leads through the gate"), Path.Contains(Layout.ToTileIndex(FHexCoord::FromOffset(4, 4))));
+		TestEqual(TEXT("The king's path is as short as the board allows"), Path.Num(),
+			FHexCoord::Distance(Layout.FromTileIndex(StartTileIndex), Layout.FromTileIndex(GoalTileIndex)) + 1);
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,128 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexGridTestUtilities.h"
+#include "Asymptomagickal/Tests/AsymTestUtilities.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHexTileGeneratorLargeBoardTest, "Asym.HexGrid.Generation.LargeBoard",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+/**
+ * Generates a 500x500 board with noise and rim on two grids with the same seed, standing in for server and client.
+ * Both have to produce the same tiles and the generation has to stay under a second.
+ */
+bool FHexTileGeneratorLargeBoardTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 BoardSize = 500;
+	static constexpr double MaxSeconds = 1.0;
+
+	AsymTests::FScopedTestWorld TestWorld;
+
+	FHexGridTestSettings Settings;
+	Settings.Rows = BoardSize;
+	Settings.Columns = BoardSize;
+	Settings.Seed = 1234;
+	Settings.GeneratorClasses = {UHexTileGenerator_Noise::StaticClass(), UHexTileGenerator_Rim::StaticClass()};
+	Settings.bBuild = false;
+
+	AHexGrid* ServerGrid = FHexGridTestAccess::SpawnGrid(TestWorld.GetWorld(), Settings);
+	AHexGrid* ClientGrid = FHexGridTestAccess::SpawnGrid(TestWorld.GetWorld(), Settings);
+	Settings.Seed += 1;
+	AHexGrid* OtherSeedGrid = FHexGridTestAccess::SpawnGrid(TestWorld.GetWorld(), Settings);
+
+	TArray<float> ServerHeights;
+	TArray<FTileStateBits> ServerStates;
+	const double StartTime = FPlatformTime::Seconds();
+	ServerGrid->GenerateTiles(ServerGrid->GetLayout(), ServerHeights, ServerStates);
+	const double Seconds = FPlatformTime::Seconds() - StartTime;
+
+	TArray<float> ClientHeights;
+	TArray<FTileStateBits> ClientStates;
+	ClientGrid->GenerateTiles(ClientGrid->GetLayout(), ClientHeights, ClientStates);
+
+	TArray<float> OtherSeedHeights;
+	TArray<FTileStateBits> OtherSeedStates;
+	OtherSeedGrid->GenerateTiles(OtherSeedGrid->GetLayout(), OtherSeedHeights, OtherSeedStates);
+
+	AddInfo(FString::Printf(TEXT("Generating %dx%d tiles took %.1f ms"), BoardSize, BoardSize, Seconds * 1000.0));
+
+	TestEqual(TEXT("Generated tiles"), ServerHeights.Num(), BoardSize * BoardSize);
+	// Bitwise, clients have to build exactly the board the server checks the replicated tiles against
+	TestTrue(TEXT("Same seed generates the same heights"), ServerHeights.Num() == ClientHeights.Num()
+		&& FMemory::Memcmp(ServerHeights.GetData(), ClientHeights.GetData(), ServerHeights.Num() * sizeof(float)) == 0);
+	TestTrue(TEXT("Same seed generates the same states"), ServerStates == ClientStates);
+	TestTrue(TEXT("Another seed generates another board"), ServerHeights != OtherSeedHeights);
+
+	if (Seconds > MaxSeconds)
+	{
+		AddError(FString::Printf(TEXT("Generating %dx%d tiles took %.2f s, more than %.0f s"), BoardSize, BoardSize, Seconds, MaxSeconds));
+	}
+
+	ServerGrid->Destroy();
+	ClientGrid->Destroy();
+	OtherSeedGrid->Destroy();
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHexTileGeneratorRaiseRimTest, "Asym.HexGrid.Generation.RaiseRimMatchesRuntime",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+/**
+ * The editor's RaiseRim has to raise the rim to the heights the runtime generation gives it, with a configured Rim
+ * generator and without one, where it acts like a Rim generator appended to the list.
+ */
+bool FHexTileGeneratorRaiseRimTest::RunTest(const FString& Parameters)
+{
+	AsymTests::FScopedTestWorld TestWorld;
+
+	FHexGridTestSettings Settings;
+	Settings.Rows = 16;
+	Settings.Columns = 16;
+	Settings.Seed = 7;
+	Settings.bBuild = false;
+
+	Settings.GeneratorClasses = {UHexTileGenerator_Noise::StaticClass(), UHexTileGenerator_Rim::StaticClass()};
+	AHexGrid* RuntimeGrid = FHexGridTestAccess::SpawnGrid(TestWorld.GetWorld(), Settings);
+
+	TArray<float> Heights;
+	TArray<FTileStateBits> States;
+	RuntimeGrid->GenerateTiles(RuntimeGrid->GetLayout(), Heights, States);
+
+	const FHexGridLayout Layout = RuntimeGrid->GetLayout();
+	const UHexTileGenerator_Rim* RimGenerator = GetDefault<UHexTileGenerator_Rim>();
+
+	Settings.GeneratorClasses.Pop();
+	AHexGrid* EditorOnlyRimGrid = FHexGridTestAccess::SpawnGrid(TestWorld.GetWorld(), Settings);
+
+	for (AHexGrid* Grid : {RuntimeGrid, EditorOnlyRimGrid})
+	{
+		FHexGridTestAccess::CreateHexGrid(*Grid);
+		FHexGridTestAccess::RandomizeHeight(*Grid);
+		FHexGridTestAccess::RaiseRim(*Grid);
+
+		const UHexInstancedStaticMeshComponent* PreviewMesh = FHexGridTestAccess::GetPreviewMesh(*Grid);
+		int32 NumMismatches = 0;
+		// Generated tiles are snapped to the replicated height quantization, the preview is not
+		const float Tolerance = 0.5f / FTileData::HeightQuantizationScale;
+		for (int32 TileIndex = 0; TileIndex < Layout.Num(); ++TileIndex)
+		{
+			FTransform Transform;
+			if (RimGenerator->IsRimTile(Layout, TileIndex) && PreviewMesh->GetInstanceTransform(TileIndex, Transform))
+			{
+				NumMismatches += !FMath::IsNearlyEqual(static_cast<float>(Transform.GetLocation().Z), Heights[TileIndex], Tolerance);
+			}
+		}
+
+		TestEqual(Grid == RuntimeGrid ? TEXT("Rim tiles raised differently than generated") : TEXT("Rim tiles raised differently than generated without a Rim generator"),
+			NumMismatches, 0);
+		Grid->Destroy();
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
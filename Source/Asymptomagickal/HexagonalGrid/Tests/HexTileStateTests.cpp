@@ -0,0 +1,104 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "Asymptomagickal/HexagonalGrid/HexTileState.h"
+#include "Asymptomagickal/Interface/TileInterface.h"
+#include "Asymptomagickal/Tests/AsymTestUtilities.h"
+#include "Misc/AutomationTest.h"
+#include "Serialization/BitWriter.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHexTileStateConversionTest, "Asym.HexGrid.TileState.Conversion",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+bool FHexTileStateConversionTest::RunTest(const FString& Parameters)
+{
+	for (int32 Bits = 0; Bits <= AsymTileState::AllBits; ++Bits)
+	{
+		const FTileStateBits StateBits = static_cast<FTileStateBits>(Bits);
+		TestEqual(FString::Printf(TEXT("Round trip of state %d"), Bits), AsymTileState::FromTags(AsymTileState::ToTags(StateBits)), StateBits);
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FHexTileStateSizeTest, "Asym.HexGrid.TileState.MemoryAndReplicationSize",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+/**
+ * Measures a 100k tile board with one permission tag per tile, stored and net serialized as the tag container tiles
+ * used to carry and as the state bits they carry now.
+ */
+bool FHexTileStateSizeTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumTiles = 100000;
+
+	if (!AsymTests::FScopedAllocationCounter::IsSupported())
+	{
+		AddWarning(TEXT("Allocations cannot be counted on this platform"));
+		return true;
+	}
+
+	const TConstArrayView<FGameplayTag> RegisteredTags = AsymTileState::GetRegisteredTags();
+
+	TArray<FGameplayTagContainer> Containers;
+	int64 ContainerAllocations = 0;
+	int64 ContainerBytes = 0;
+	{
+		AsymTests::FScopedAllocationCounter AllocationCounter;
+		Containers.SetNum(NumTiles);
+		for (int32 TileIndex = 0; TileIndex < NumTiles; ++TileIndex)
+		{
+			Containers[TileIndex].AddTag(RegisteredTags[TileIndex % RegisteredTags.Num()]);
+		}
+		ContainerAllocations = AllocationCounter.GetNumAllocations();
+		ContainerBytes = AllocationCounter.GetAllocatedBytes();
+	}
+
+	TArray<FTileStateBits> States;
+	int64 StateAllocations = 0;
+	int64 StateBytes = 0;
+	{
+		AsymTests::FScopedAllocationCounter AllocationCounter;
+		// Reserved exactly, growing would add the slack of DefaultCalculateSlackGrow
+		States.Reserve(NumTiles);
+		States.SetNumUninitialized(NumTiles);
+		for (int32 TileIndex = 0; TileIndex < NumTiles; ++TileIndex)
+		{
+			States[TileIndex] = AsymTileState::GetBit(RegisteredTags[TileIndex % RegisteredTags.Num()]);
+		}
+		StateAllocations = AllocationCounter.GetNumAllocations();
+		StateBytes = AllocationCounter.GetAllocatedBytes();
+	}
+
+	FBitWriter ContainerWriter(0, true);
+	for (FGameplayTagContainer& Container : Containers)
+	{
+		bool bSuccess = true;
+		Container.NetSerialize(ContainerWriter, nullptr, bSuccess);
+	}
+
+	// Same encoding as FTileData::NetSerialize and FTileDataNetSerializer
+	FBitWriter StateWriter(0, true);
+	for (FTileStateBits& State : States)
+	{
+		StateWriter.SerializeBits(&State, AsymTileState::NumBits);
+	}
+
+	AddInfo(FString::Printf(TEXT("Tag containers: %lld allocations, %lld bytes, %.1f bits per tile"),
+		ContainerAllocations, ContainerBytes, static_cast<double>(ContainerWriter.GetNumBits()) / NumTiles));
+	AddInfo(FString::Printf(TEXT("State bits: %lld allocations, %lld bytes, %.1f bits per tile"),
+		StateAllocations, StateBytes, static_cast<double>(StateWriter.GetNumBits()) / NumTiles));
+
+	TestEqual(TEXT("State bits allocations"), StateAllocations, static_cast<int64>(1));
+	// The allocator may round the request up, the array's allocated size includes that
+	TestEqual(TEXT("State bits bytes"), StateBytes, static_cast<int64>(States.GetAllocatedSize()));
+	TestEqual(TEXT("Serialized state bits"), StateWriter.GetNumBits(), static_cast<int64>(NumTiles * AsymTileState::NumBits));
+	TestTrue(TEXT("State bits use less memory than tag containers"), StateBytes < ContainerBytes);
+	TestTrue(TEXT("State bits serialize smaller than tag containers"), StateWriter.GetNumBits() < ContainerWriter.GetNumBits());
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
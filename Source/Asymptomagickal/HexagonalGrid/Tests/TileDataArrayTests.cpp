@@ -0,0 +1,90 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "Asymptomagickal/Interface/TileInterface.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTileDataArrayLookupTest, "Asym.HexGrid.TileDataArray.Lookup",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::PerfFilter)
+
+/**
+ * Fills the array in shuffled order like a client receives it, swaps items around with removals and times random
+ * FindTile calls. A linear search would get 100 times slower from 10k to 1M tiles, the lookup has to stay flat.
+ */
+bool FTileDataArrayLookupTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 NumLookups = 1000000;
+	// Hash map lookups get slower once the map leaves the caches, but nowhere near the 100x of a scan
+	static constexpr double MaxSlowdown = 10.0;
+
+	double BaselineNanoseconds = 0.0;
+
+	for (const int32 NumTiles : {10000, 100000, 1000000})
+	{
+		FRandomStream Random(NumTiles);
+
+		TArray<int32> TileIndices;
+		TileIndices.SetNumUninitialized(NumTiles);
+		for (int32 TileIndex = 0; TileIndex < NumTiles; ++TileIndex)
+		{
+			TileIndices[TileIndex] = TileIndex;
+		}
+		for (int32 Slot = NumTiles - 1; Slot > 0; --Slot)
+		{
+			TileIndices.Swap(Slot, Random.RandHelper(Slot + 1));
+		}
+
+		FTileDataArray TileArray;
+		TileArray.Items.Reserve(NumTiles);
+		for (const int32 TileIndex : TileIndices)
+		{
+			FTileData Tile;
+			Tile.TileIndex = TileIndex;
+			TileArray.AddTile(Tile);
+		}
+
+		// Every removal swaps the last item into the freed slot
+		const int32 NumRemovals = NumTiles / 10;
+		for (int32 Removal = 0; Removal < NumRemovals; ++Removal)
+		{
+			TileArray.RemoveTile(TileIndices[Removal]);
+		}
+
+		TArray<int32> LookupIndices;
+		LookupIndices.SetNumUninitialized(NumLookups);
+		for (int32& TileIndex : LookupIndices)
+		{
+			TileIndex = TileIndices[NumRemovals + Random.RandHelper(NumTiles - NumRemovals)];
+		}
+
+		int32 NumWrongTiles = 0;
+		const double StartTime = FPlatformTime::Seconds();
+		for (const int32 TileIndex : LookupIndices)
+		{
+			const FTileData* Tile = TileArray.FindTile(TileIndex);
+			NumWrongTiles += !Tile || Tile->TileIndex != TileIndex;
+		}
+		const double Nanoseconds = (FPlatformTime::Seconds() - StartTime) * 1e9 / NumLookups;
+
+		TestEqual(FString::Printf(TEXT("Tiles found wrongly in %d tiles"), NumTiles), NumWrongTiles, 0);
+		TestNull(FString::Printf(TEXT("Removed tile found in %d tiles"), NumTiles), TileArray.FindTile(TileIndices[0]));
+
+		AddInfo(FString::Printf(TEXT("FindTile with %d tiles: %.1f ns"), NumTiles, Nanoseconds));
+
+		if (BaselineNanoseconds == 0.0)
+		{
+			BaselineNanoseconds = Nanoseconds;
+		}
+		else if (Nanoseconds > BaselineNanoseconds * MaxSlowdown)
+		{
+			AddError(FString::Printf(TEXT("FindTile with %d tiles took %.1f ns, more than %.0fx the %.1f ns with 10000 tiles"),
+				NumTiles, Nanoseconds, MaxSlowdown, BaselineNanoseconds));
+		}
+	}
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
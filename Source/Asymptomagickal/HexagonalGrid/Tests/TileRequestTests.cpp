@@ -0,0 +1,123 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "HexGridTestUtilities.h"
+#include "Asymptomagickal/Component/TileInteraction.h"
+#include "Asymptomagickal/HexagonalGrid/HexGridNetStats.h"
+#include "Asymptomagickal/Tests/AsymTestUtilities.h"
+#include "Misc/AutomationTest.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FTileRequestBatchingTest, "Asym.HexGrid.TileRequests.Batching",
+	EAutomationTestFlags::EditorContext | EAutomationTestFlags::ClientContext | EAutomationTestFlags::ServerContext | EAutomationTestFlags::EngineFilter)
+
+/**
+ * Replays the same client request storm once batched and once as one RPC per tile like before batching, the same as
+ * Asym.HexGrid.RequestSoak does on a real client. Frames advance in simulated time and the batched requests are flushed
+ * at the end of every frame, where the next tick would send them.
+ * Batching has to send at most one RPC per frame, keep the RPCs of one round trip, none of which can have been
+ * acknowledged, far below the per tile sends and leave the server with the same board.
+ */
+bool FTileRequestBatchingTest::RunTest(const FString& Parameters)
+{
+	static constexpr int32 FramesPerSecond = 60;
+	static constexpr int32 Seconds = 5;
+	static constexpr float TilesPerSecond = 2000.f;
+	static constexpr int32 RoundTripFrames = FramesPerSecond / 5;
+
+	AsymTests::FScopedTestWorld TestWorld;
+
+	struct FStormResult
+	{
+		int64 NumRPCs = 0;
+		int64 NumTiles = 0;
+		int64 MaxRPCsInFlight = 0;
+	};
+
+	const auto RunStorm = [&TestWorld](AHexGrid* Grid, const bool bPerTileRPCs)
+	{
+		// A client's tile interaction, the server RPC runs right away in the standalone test world
+		AActor* Owner = TestWorld.GetWorld()->SpawnActor<AActor>();
+		UTileInteraction* TileInteraction = NewObject<UTileInteraction>(Owner);
+		TileInteraction->RegisterComponent();
+		Owner->SetRole(ROLE_AutonomousProxy);
+
+		FHexGridNetStats& NetStats = FHexGridNetStats::Get();
+		NetStats.Reset();
+
+		FRandomStream Random(FramesPerSecond);
+		const int32 NumTiles = Grid->GetTileStore().Num();
+		float Budget = 0.f;
+
+		TArray<int64> FrameRPCs;
+		FStormResult Result;
+		for (int32 Frame = 0; Frame < Seconds * FramesPerSecond; ++Frame)
+		{
+			const int64 NumRPCsBefore = NetStats.NumRequestRPCs;
+
+			Budget += TilesPerSecond / FramesPerSecond;
+			const int32 NumFrameTiles = FMath::FloorToInt32(Budget);
+			Budget -= NumFrameTiles;
+
+			for (int32 Tile = 0; Tile < NumFrameTiles; ++Tile)
+			{
+				const int32 TileIndex = Random.RandHelper(NumTiles);
+				const FTileStateBits StateBits = static_cast<FTileStateBits>(1 << Random.RandHelper(AsymTileState::NumBits));
+				TileInteraction->RequestTilesTagChange(Grid, {TileIndex}, AsymTileState::ToTags(StateBits));
+
+				if (bPerTileRPCs)
+				{
+					TileInteraction->FlushTileRequests();
+				}
+			}
+			TileInteraction->FlushTileRequests();
+
+			FrameRPCs.Add(NetStats.NumRequestRPCs - NumRPCsBefore);
+
+			int64 NumInFlight = 0;
+			for (int32 RoundTripFrame = FMath::Max(0, FrameRPCs.Num() - RoundTripFrames); RoundTripFrame < FrameRPCs.Num(); ++RoundTripFrame)
+			{
+				NumInFlight += FrameRPCs[RoundTripFrame];
+			}
+			Result.MaxRPCsInFlight = FMath::Max(Result.MaxRPCsInFlight, NumInFlight);
+		}
+
+		Result.NumRPCs = NetStats.NumRequestRPCs;
+		Result.NumTiles = NetStats.NumRequestedTiles;
+		Owner->Destroy();
+		return Result;
+	};
+
+	FHexGridTestSettings Settings;
+	AHexGrid* BatchedGrid = FHexGridTestAccess::SpawnGrid(TestWorld.GetWorld(), Settings);
+	AHexGrid* PerTileGrid = FHexGridTestAccess::SpawnGrid(TestWorld.GetWorld(), Settings);
+
+	const FStormResult Batched = RunStorm(BatchedGrid, false);
+	const FStormResult PerTile = RunStorm(PerTileGrid, true);
+
+	AddInfo(FString::Printf(TEXT("Batched: %lld RPCs for %lld tiles, at most %lld RPCs per round trip"), Batched.NumRPCs, Batched.NumTiles, Batched.MaxRPCsInFlight));
+	AddInfo(FString::Printf(TEXT("Per tile: %lld RPCs for %lld tiles, at most %lld RPCs per round trip"), PerTile.NumRPCs, PerTile.NumTiles, PerTile.MaxRPCsInFlight));
+
+	const int32 NumFrames = Seconds * FramesPerSecond;
+	TestEqual(TEXT("Per tile RPCs"), PerTile.NumRPCs, PerTile.NumTiles);
+	TestTrue(TEXT("Batching sends at most one RPC per frame"), Batched.NumRPCs <= NumFrames);
+	TestTrue(TEXT("Batched RPCs per round trip stay within the frames of a round trip"), Batched.MaxRPCsInFlight <= RoundTripFrames);
+	TestTrue(TEXT("Batching keeps a tenth of the per tile RPCs in flight at most"), Batched.MaxRPCsInFlight * 10 <= PerTile.MaxRPCsInFlight);
+	// Repeated requests for a tile within a frame are coalesced, the last one wins like it would one by one
+	TestTrue(TEXT("Batching requests no more tiles"), Batched.NumTiles <= PerTile.NumTiles);
+
+	int32 NumDifferentTiles = 0;
+	for (int32 TileIndex = 0; TileIndex < BatchedGrid->GetTileStore().Num(); ++TileIndex)
+	{
+		NumDifferentTiles += BatchedGrid->GetTileStore().GetState(TileIndex) != PerTileGrid->GetTileStore().GetState(TileIndex);
+	}
+	TestEqual(TEXT("Tiles that end up different"), NumDifferentTiles, 0);
+
+	BatchedGrid->Destroy();
+	PerTileGrid->Destroy();
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
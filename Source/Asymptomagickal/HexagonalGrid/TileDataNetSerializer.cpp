@@ -0,0 +1,234 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "TileDataNetSerializer.h"
+
+#include "Asymptomagickal/Interface/TileInterface.h"
+#include "Iris/ReplicationState/PropertyNetSerializerInfoRegistry.h"
+#include "Iris/Serialization/NetBitStreamReader.h"
+#include "Iris/Serialization/NetBitStreamUtil.h"
+#include "Iris/Serialization/NetBitStreamWriter.h"
+#include "Iris/Serialization/NetSerializerDelegates.h"
+
+#include UE_INLINE_GENERATED_CPP_BY_NAME(TileDataNetSerializer)
+
+namespace AsymTileDataNetSerializer
+{
+	// Tile indices are written +1 so the invalid index -1 packs into a single byte
+	constexpr uint32 PackTileIndex(const int32 TileIndex) { return static_cast<uint32>(TileIndex + 1); }
+	constexpr int32 UnpackTileIndex(const uint32 Packed) { return static_cast<int32>(Packed) - 1; }
+
+	// ZigZag keeps small negative heights small when packed
+	constexpr uint32 PackHeight(const int32 Height) { return (static_cast<uint32>(Height) << 1) ^ static_cast<uint32>(Height >> 31); }
+	constexpr int32 UnpackHeight(const uint32 Packed) { return static_cast<int32>(Packed >> 1) ^ -static_cast<int32>(Packed & 1); }
+
+	constexpr uint8 StateMask = static_cast<uint8>((1 << AsymTileState::NumBits) - 1);
+}
+
+bool FTileData::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	using namespace AsymTileDataNetSerializer;
+
+	uint32 PackedIndex = PackTileIndex(TileIndex);
+	uint32 PackedHeight = PackHeight(QuantizeHeight(Height));
+	uint8 Bits = StateBits;
+
+	Ar.SerializeIntPacked(PackedIndex);
+	Ar.SerializeIntPacked(PackedHeight);
+	Ar.SerializeBits(&Bits, AsymTileState::NumBits);
+
+	if (Ar.IsLoading())
+	{
+		TileIndex = UnpackTileIndex(PackedIndex);
+		Height = DequantizeHeight(UnpackHeight(PackedHeight));
+		StateBits = Bits & StateMask;
+	}
+
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+namespace UE::Net
+{
+
+struct FTileDataNetSerializer
+{
+	static const uint32 Version = 0;
+
+	struct FQuantizedType
+	{
+		int32 TileIndex;
+		int32 Height;
+		uint8 StateBits;
+	};
+
+	typedef FTileData SourceType;
+	typedef FQuantizedType QuantizedType;
+	typedef FTileDataNetSerializerConfig ConfigType;
+
+	static const ConfigType DefaultConfig;
+
+	static void Serialize(FNetSerializationContext&, const FNetSerializeArgs&);
+	static void Deserialize(FNetSerializationContext&, const FNetDeserializeArgs&);
+
+	static void SerializeDelta(FNetSerializationContext&, const FNetSerializeDeltaArgs&);
+	static void DeserializeDelta(FNetSerializationContext&, const FNetDeserializeDeltaArgs&);
+
+	static void Quantize(FNetSerializationContext&, const FNetQuantizeArgs&);
+	static void Dequantize(FNetSerializationContext&, const FNetDequantizeArgs&);
+
+	static bool IsEqual(FNetSerializationContext&, const FNetIsEqualArgs&);
+	static bool Validate(FNetSerializationContext&, const FNetValidateArgs&);
+
+private:
+	class FNetSerializerRegistryDelegates final : private UE::Net::FNetSerializerRegistryDelegates
+	{
+	public:
+		virtual ~FNetSerializerRegistryDelegates();
+
+	private:
+		virtual void OnPreFreezeNetSerializerRegistry() override;
+	};
+
+	static FTileDataNetSerializer::FNetSerializerRegistryDelegates NetSerializerRegistryDelegates;
+};
+
+UE_NET_IMPLEMENT_SERIALIZER(FTileDataNetSerializer);
+
+const FTileDataNetSerializer::ConfigType FTileDataNetSerializer::DefaultConfig;
+FTileDataNetSerializer::FNetSerializerRegistryDelegates FTileDataNetSerializer::NetSerializerRegistryDelegates;
+
+void FTileDataNetSerializer::Serialize(FNetSerializationContext& Context, const FNetSerializeArgs& Args)
+{
+	using namespace AsymTileDataNetSerializer;
+
+	const QuantizedType& Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+	FNetBitStreamWriter* Writer = Context.GetBitStreamWriter();
+
+	WritePackedUint32(Writer, PackTileIndex(Value.TileIndex));
+	WritePackedUint32(Writer, PackHeight(Value.Height));
+	Writer->WriteBits(Value.StateBits, AsymTileState::NumBits);
+}
+
+void FTileDataNetSerializer::Deserialize(FNetSerializationContext& Context, const FNetDeserializeArgs& Args)
+{
+	using namespace AsymTileDataNetSerializer;
+
+	QuantizedType& Target = *reinterpret_cast<QuantizedType*>(Args.Target);
+	FNetBitStreamReader* Reader = Context.GetBitStreamReader();
+
+	Target.TileIndex = UnpackTileIndex(ReadPackedUint32(Reader));
+	Target.Height = UnpackHeight(ReadPackedUint32(Reader));
+	Target.StateBits = static_cast<uint8>(Reader->ReadBits(AsymTileState::NumBits));
+}
+
+void FTileDataNetSerializer::SerializeDelta(FNetSerializationContext& Context, const FNetSerializeDeltaArgs& Args)
+{
+	using namespace AsymTileDataNetSerializer;
+
+	const QuantizedType& Value = *reinterpret_cast<const QuantizedType*>(Args.Source);
+	const QuantizedType& PrevValue = *reinterpret_cast<const QuantizedType*>(Args.Prev);
+	FNetBitStreamWriter* Writer = Context.GetBitStreamWriter();
+
+	// Tiles never move, a tag change usually costs three bits plus the state
+	if (Writer->WriteBool(Value.TileIndex != PrevValue.TileIndex))
+	{
+		WritePackedUint32(Writer, PackTileIndex(Value.TileIndex));
+	}
+
+	if (Writer->WriteBool(Value.Height != PrevValue.Height))
+	{
+		WritePackedUint32(Writer, PackHeight(Value.Height - PrevValue.Height));
+	}
+
+	if (Writer->WriteBool(Value.StateBits != PrevValue.StateBits))
+	{
+		Writer->WriteBits(Value.StateBits ^ PrevValue.StateBits, AsymTileState::NumBits);
+	}
+}
+
+void FTileDataNetSerializer::DeserializeDelta(FNetSerializationContext& Context, const FNetDeserializeDeltaArgs& Args)
+{
+	using namespace AsymTileDataNetSerializer;
+
+	QuantizedType& Target = *reinterpret_cast<QuantizedType*>(Args.Target);
+	const QuantizedType& PrevValue = *reinterpret_cast<const QuantizedType*>(Args.Prev);
+	FNetBitStreamReader* Reader = Context.GetBitStreamReader();
+
+	Target = PrevValue;
+
+	if (Reader->ReadBool())
+	{
+		Target.TileIndex = UnpackTileIndex(ReadPackedUint32(Reader));
+	}
+
+	if (Reader->ReadBool())
+	{
+		Target.Height = PrevValue.Height + UnpackHeight(ReadPackedUint32(Reader));
+	}
+
+	if (Reader->ReadBool())
+	{
+		Target.StateBits = PrevValue.StateBits ^ static_cast<uint8>(Reader->ReadBits(AsymTileState::NumBits));
+	}
+}
+
+void FTileDataNetSerializer::Quantize(FNetSerializationContext& Context, const FNetQuantizeArgs& Args)
+{
+	const SourceType& Source = *reinterpret_cast<const SourceType*>(Args.Source);
+	QuantizedType& Target = *reinterpret_cast<QuantizedType*>(Args.Target);
+
+	Target.TileIndex = Source.TileIndex;
+	Target.Height = FTileData::QuantizeHeight(Source.Height);
+	Target.StateBits = Source.StateBits & AsymTileDataNetSerializer::StateMask;
+}
+
+void FTileDataNetSerializer::Dequantize(FNetSerializationContext& Context, const FNetDequantizeArgs& Args)
+{
+	const QuantizedType& Source = *reinterpret_cast<const QuantizedType*>(Args.Source);
+	SourceType& Target = *reinterpret_cast<SourceType*>(Args.Target);
+
+	Target.TileIndex = Source.TileIndex;
+	Target.Height = FTileData::DequantizeHeight(Source.Height);
+	Target.StateBits = Source.StateBits;
+}
+
+bool FTileDataNetSerializer::IsEqual(FNetSerializationContext& Context, const FNetIsEqualArgs& Args)
+{
+	if (Args.bStateIsQuantized)
+	{
+		const QuantizedType& Value0 = *reinterpret_cast<const QuantizedType*>(Args.Source0);
+		const QuantizedType& Value1 = *reinterpret_cast<const QuantizedType*>(Args.Source1);
+
+		return Value0.TileIndex == Value1.TileIndex && Value0.Height == Value1.Height && Value0.StateBits == Value1.StateBits;
+	}
+
+	const SourceType& Value0 = *reinterpret_cast<const SourceType*>(Args.Source0);
+	const SourceType& Value1 = *reinterpret_cast<const SourceType*>(Args.Source1);
+
+	return Value0.TileIndex == Value1.TileIndex
+		&& FTileData::QuantizeHeight(Value0.Height) == FTileData::QuantizeHeight(Value1.Height)
+		&& Value0.StateBits == Value1.StateBits;
+}
+
+bool FTileDataNetSerializer::Validate(FNetSerializationContext& Context, const FNetValidateArgs& Args)
+{
+	const SourceType& Source = *reinterpret_cast<const SourceType*>(Args.Source);
+
+	return Source.TileIndex >= INDEX_NONE && (Source.StateBits & ~AsymTileDataNetSerializer::StateMask) == 0;
+}
+
+static const FName PropertyNetSerializerRegistry_NAME_TileData("TileData");
+UE_NET_IMPLEMENT_NAMED_STRUCT_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_TileData, FTileDataNetSerializer);
+
+FTileDataNetSerializer::FNetSerializerRegistryDelegates::~FNetSerializerRegistryDelegates()
+{
+	UE_NET_UNREGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_TileData);
+}
+
+void FTileDataNetSerializer::FNetSerializerRegistryDelegates::OnPreFreezeNetSerializerRegistry()
+{
+	UE_NET_REGISTER_NETSERIALIZER_INFO(PropertyNetSerializerRegistry_NAME_TileData);
+}
+
+}
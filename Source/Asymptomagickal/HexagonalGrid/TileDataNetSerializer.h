@@ -0,0 +1,22 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Iris/Serialization/NetSerializer.h"
+#include "TileDataNetSerializer.generated.h"
+
+/**
+ * Iris serializer for FTileData, only sends the tile index, the quantized height and the tile state bits.
+ * X and Y are never sent since they follow from the tile index and the grid layout.
+ */
+USTRUCT()
+struct FTileDataNetSerializerConfig : public FNetSerializerConfig
+{
+	GENERATED_BODY()
+};
+
+namespace UE::Net
+{
+	UE_NET_DECLARE_SERIALIZER(FTileDataNetSerializer, ASYMPTOMAGICKAL_API);
+}
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "GameplayTagContainer.h"
+#include "Asymptomagickal/HexagonalGrid/HexTileState.h"
 #include "Iris/ReplicationState/IrisFastArraySerializer.h"
 #include "Net/Serialization/FastArraySerializer.h"
 #include "UObject/Interface.h"
@@ -25,10 +26,14 @@ struct FTileData : public FFastArraySerializerItem
 
 	UPROPERTY(BlueprintReadOnly, Category = "Tile Data")
 	int32 TileIndex = -1;
+	/** Height of the tile, X and Y follow from the TileIndex and the grid layout */
 	UPROPERTY(BlueprintReadOnly, Category = "Tile Data")
-	FVector_NetQuantize HexCoordinates; //NetQuantize for 0 floating point precision
+	float Height = 0.f;
+	/** Registered tile tags as bits, see AsymTileState */
 	UPROPERTY(BlueprintReadOnly, Category = "Tile Data")
-	FGameplayTagContainer GameplayTags = FGameplayTagContainer();
+	uint8 StateBits = AsymTileState::None;
+
+	FGameplayTagContainer GetGameplayTags() const { return AsymTileState::ToTags(StateBits); }
 
 	void PreReplicatedRemove(const struct FTileDataArray& InArraySerializer);
 	void PostReplicatedAdd(const struct FTileDataArray& InArraySerializer);
@@ -38,6 +43,27 @@ struct FTileData : public FFastArraySerializerItem
 	{
 		return TileIndex == OtherIndex;
 	}
+
+	/** Heights replicate in steps of 1 / HeightQuantizationScale units */
+	static constexpr float HeightQuantizationScale = 8.f;
+
+	static int32 QuantizeHeight(const float InHeight) { return FMath::RoundToInt32(InHeight * HeightQuantizationScale); }
+	static float DequantizeHeight(const int32 QuantizedHeight) { return QuantizedHeight / HeightQuantizationScale; }
+
+	/** Snaps the height to what clients will receive, so server and clients work with identical values */
+	void SetHeight(const float InHeight) { Height = DequantizeHeight(QuantizeHeight(InHeight)); }
+
+	/** Used by the generic replication path, Iris uses FTileDataNetSerializer */
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+};
+
+template<>
+struct TStructOpsTypeTraits<FTileData> : public TStructOpsTypeTraitsBase2<FTileData>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
 };
 
 
@@ -53,6 +79,34 @@ struct FTileDataArray : public FIrisFastArraySerializer
 	{
 		return FastArrayDeltaSerialize<FTileData, FTileDataArray>( Items, DeltaParams, *this );
 	}
+
+	void PostReplicatedReceive(const FFastArraySerializer::FPostReplicatedReceiveParameters& Parameters);
+
+	/** O(1) lookup of a tile by its TileIndex, returns nullptr if the tile is not in the array */
+	FTileData* FindTile(const int32 TileIndex);
+	const FTileData* FindTile(const int32 TileIndex) const;
+
+	/** Appends a tile on the authority and registers it in the lookup */
+	FTileData& AddTile(const FTileData& NewTile);
+
+	/** Removes a tile on the authority, the last item is swapped into its slot. Call MarkArrayDirty once after removing */
+	bool RemoveTile(const int32 TileIndex);
+
+	/** Clears all items and the lookup */
+	void Reset();
+
+	/** Flags the lookup as stale, it gets rebuilt on the next FindTile miss */
+	void MarkLookupDirty() const { bLookupDirty = true; }
+
+private:
+	void RebuildLookup() const;
+
+	/**
+	 * TileIndex -> slot in Items. The server adds tiles in order, but clients receive them in whatever order the fast array
+	 * delivers and removals swap items around, so every hit is validated against the slot and stale entries trigger a rebuild.
+	 */
+	mutable TMap<int32, int32> TileLookup;
+	mutable bool bLookupDirty = false;
 };
 
 template<>
@@ -81,7 +135,20 @@ class ASYMPTOMAGICKAL_API ITileInterface
 	GENERATED_BODY()
 
 public:
+	/** Item is the tile index */
 	virtual FTileData GetTileDataFromItem(const int32 Item) = 0;
 	
 	virtual void SetTagsOnTile(const int32 TileIndex, const FGameplayTagContainer& Tags) = 0;
+
+	/**
+	 * Server only, sets the same state on all tiles in one pass. The instigator is whoever requested the change, if anyone.
+	 * Returns how many of the tile indices are not on the grid, those are skipped without logging so callers can report them once.
+	 */
+	virtual int32 SetStateOnTiles(const TConstArrayView<int32> TileIndices, const FTileStateBits StateBits, AActor* Instigator = nullptr) = 0;
+
+	/** Maps a hit instance of one of the grid's components to its tile index, INDEX_NONE if it is not a tile */
+	virtual int32 GetTileIndexFromInstance(const UPrimitiveComponent* Component, const int32 InstanceIndex) const = 0;
+
+	/** Picks the first tile along the world space segment without a physics trace */
+	virtual bool RaycastTile(const FVector& Start, const FVector& End, int32& OutTileIndex, FVector& OutHitLocation) const = 0;
 };
@@ -0,0 +1,129 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+
+#include "AsymTestUtilities.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "HAL/MemoryBase.h"
+
+namespace AsymTests
+{
+	/** Counter of the scope the thread is in, a plain pointer so reading it while allocating needs no allocation itself */
+	static thread_local FScopedAllocationCounter* GThreadAllocationCounter = nullptr;
+
+	/**
+	 * Forwards everything to the allocator it was put in front of and counts into the thread's allocation counter
+	 */
+	class FCountingMalloc final : public FMalloc
+	{
+	public:
+		explicit FCountingMalloc(FMalloc* InInner)
+			: Inner(InInner)
+		{
+		}
+
+		FMalloc* const Inner;
+
+		virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation(Count);
+			return Inner->Malloc(Count, Alignment);
+		}
+
+		virtual void* TryMalloc(SIZE_T Count, uint32 Alignment) override
+		{
+			CountAllocation(Count);
+			return Inner->TryMalloc(Count, Alignment);
+		}
+
+		virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			// Reallocating to 0 frees
+			if (Count > 0)
+			{
+				CountAllocation(Count);
+			}
+			return Inner->Realloc(Original, Count, Alignment);
+		}
+
+		virtual void* TryRealloc(void* Original, SIZE_T Count, uint32 Alignment) override
+		{
+			if (Count > 0)
+			{
+				CountAllocation(Count);
+			}
+			return Inner->TryRealloc(Original, Count, Alignment);
+		}
+
+		virtual void Free(void* Original) override { Inner->Free(Original); }
+		virtual SIZE_T QuantizeSize(SIZE_T Count, uint32 Alignment) override { return Inner->QuantizeSize(Count, Alignment); }
+		virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override { return Inner->GetAllocationSize(Original, SizeOut); }
+		virtual bool IsInternallyThreadSafe() const override { return Inner->IsInternallyThreadSafe(); }
+		virtual bool ValidateHeap() override { return Inner->ValidateHeap(); }
+		virtual void Trim(bool bTrimThreadCaches) override { Inner->Trim(bTrimThreadCaches); }
+		virtual void SetupTLSCachesOnCurrentThread() override { Inner->SetupTLSCachesOnCurrentThread(); }
+		virtual void ClearAndDisableTLSCachesOnCurrentThread() override { Inner->ClearAndDisableTLSCachesOnCurrentThread(); }
+		virtual void InitializeStatsMetadata() override { Inner->InitializeStatsMetadata(); }
+		virtual void UpdateStats() override { Inner->UpdateStats(); }
+		virtual void GetAllocatorStats(FGenericMemoryStats& OutStats) override { Inner->GetAllocatorStats(OutStats); }
+		virtual void DumpAllocatorStats(FOutputDevice& Ar) override { Inner->DumpAllocatorStats(Ar); }
+		virtual const TCHAR* GetDescriptiveName() override { return TEXT("AsymCountingMalloc"); }
+
+	private:
+		static void CountAllocation(const SIZE_T Count)
+		{
+			if (FScopedAllocationCounter* Counter = GThreadAllocationCounter)
+			{
+				++Counter->NumAllocations;
+				Counter->AllocatedBytes += Count;
+			}
+		}
+	};
+
+	/** Never freed, threads that read GMalloc before it was uninstalled may still call into it */
+	static FCountingMalloc* GCountingMalloc = nullptr;
+
+	void InstallAllocationCounter()
+	{
+#if !PLATFORM_USES_FIXED_GMalloc_CLASS
+		check(IsInGameThread() && !GCountingMalloc && GMalloc);
+		// FMalloc news itself from the system allocator
+		GCountingMalloc = new FCountingMalloc(GMalloc);
+		GMalloc = GCountingMalloc;
+#endif
+	}
+
+	void UninstallAllocationCounter()
+	{
+#if !PLATFORM_USES_FIXED_GMalloc_CLASS
+		// Only undone if nothing was put in front of it since, the allocator has to stay in the chain otherwise
+		if (GCountingMalloc && GMalloc == GCountingMalloc)
+		{
+			GMalloc = GCountingMalloc->Inner;
+		}
+#endif
+	}
+
+	FScopedAllocationCounter::FScopedAllocationCounter()
+	{
+		check(!GThreadAllocationCounter);
+		GThreadAllocationCounter = this;
+	}
+
+	FScopedAllocationCounter::~FScopedAllocationCounter()
+	{
+		GThreadAllocationCounter = nullptr;
+	}
+
+	bool FScopedAllocationCounter::IsSupported()
+	{
+#if !PLATFORM_USES_FIXED_GMalloc_CLASS
+		return GCountingMalloc && GMalloc == GCountingMalloc;
+#else
+		return false;
+#endif
+	}
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
@@ -0,0 +1,89 @@
+// Copyright 2024 Nic, Vlad, Alex
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+
+namespace AsymTests
+{
+	/**
+	 * Puts the allocation counting allocator in front of GMalloc, once for the whole run so no thread can be inside it
+	 * while it is swapped out. The game module installs it on startup and removes it on shutdown.
+	 */
+	ASYMPTOMAGICKAL_API void InstallAllocationCounter();
+	ASYMPTOMAGICKAL_API void UninstallAllocationCounter();
+
+	/**
+	 * Counts the heap allocations and the requested bytes of the calling thread while in scope, other threads are not
+	 * counted. Scopes must not nest on a thread.
+	 * Platforms that bind GMalloc to a fixed class at compile time cannot be observed, IsSupported is false there.
+	 */
+	class ASYMPTOMAGICKAL_API FScopedAllocationCounter
+	{
+	public:
+		FScopedAllocationCounter();
+		~FScopedAllocationCounter();
+
+		UE_NONCOPYABLE(FScopedAllocationCounter);
+
+		/** Whether the counting allocator is installed, allocations are not counted otherwise */
+		static bool IsSupported();
+
+		/** Counts up to now while in scope, the final counts after the scope ended */
+		int64 GetNumAllocations() const { return NumAllocations; }
+		int64 GetAllocatedBytes() const { return AllocatedBytes; }
+
+	private:
+		friend class FCountingMalloc;
+
+		int64 NumAllocations = 0;
+		int64 AllocatedBytes = 0;
+	};
+
+	/**
+	 * Standalone game world that only lives for the scope, tests spawn their actors into it instead of whatever world
+	 * happens to run. It has begun play, but nothing ticks it and it has no game mode or net driver.
+	 */
+	class FScopedTestWorld
+	{
+	public:
+		FScopedTestWorld()
+		{
+			World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("AsymTestWorld"));
+			World->AddToRoot();
+
+			FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+			WorldContext.SetCurrentWorld(World);
+
+			World->InitializeActorsForPlay(FURL());
+			World->BeginPlay();
+			// Without a game mode nobody tells the world settings to start play
+			if (!World->HasBegunPlay())
+			{
+				World->GetWorldSettings()->NotifyBeginPlay();
+			}
+		}
+
+		~FScopedTestWorld()
+		{
+			GEngine->DestroyWorldContext(World);
+			World->DestroyWorld(false);
+			World->RemoveFromRoot();
+		}
+
+		UE_NONCOPYABLE(FScopedTestWorld);
+
+		UWorld* GetWorld() const { return World; }
+
+	private:
+		UWorld* World = nullptr;
+	};
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS